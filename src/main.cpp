@@ -62,6 +62,10 @@ void extensionInit() {
 }
 
 void extensionDeInit() {
+    // pending write-behind writes are written out while everything is still alive
+    if (server) {
+        server->flushWrites();
+    }
     threadpool.reset();
     //logging::logfile->flush();
     spdlog::drop_all();
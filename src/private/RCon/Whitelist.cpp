@@ -50,10 +50,11 @@ void Whitelist::set_max_players(int _players) {
 
 // VPN DETECT
 
-void Whitelist::enable_vpn_detection(const std::string& api_key, bool flag_if_suspecious) {
+void Whitelist::enable_vpn_detection(const std::string& api_key, bool flag_if_suspecious, size_t threads, size_t queue_max) {
     this->enable_vpnchecks = true;
 
     this->vpn = std::make_shared<VPNDetection>(api_key, flag_if_suspecious, true);
+    this->vpn_executor = std::make_unique<Executor>("vpn", threads, queue_max);
 }
 
 void Whitelist::set_vpn_detect_kick_msg(const std::string& _msg) {
@@ -65,6 +66,12 @@ void Whitelist::add_vpn_detection_guid_exception(const std::string& _guid) {
     this->vpn_whitelisted_guids.insert(_guid);
 }
 
+void Whitelist::append_vpn_stats(std::vector<std::pair<std::string, uint64_t>>& _out) {
+    if (this->vpn_executor) {
+        this->vpn_executor->appendStats(_out, "vpn");
+    }
+}
+
 // rcon callbacks
 void Whitelist::on_player_connected(const RconPlayerInfo& info) {
 
@@ -91,15 +98,20 @@ void Whitelist::on_player_verified(const RconPlayerInfo& info) {
     // vpn check
     if (this->enable_vpnchecks && info.ip.length() > 1 && !this->is_vpn_whitelisted_player(info.guid)) {
 
-        threadpool->fireAndForget([this, ip = info.ip, number = info.number ]() {
-            bool vpn_detected = false;
-            bool request_throtteled = false;
-            this->vpn->check_vpn(ip, vpn_detected, request_throtteled);
+        try {
+            this->vpn_executor->fireAndForget([this, ip = info.ip, number = info.number ]() {
+                bool vpn_detected = false;
+                bool request_throtteled = false;
+                this->vpn->check_vpn(ip, vpn_detected, request_throtteled);
 
-            if (vpn_detected) {
-                this->rcon->send_command("kick " + number + " " + this->kick_message_vpn);
-            }
-        });
+                if (vpn_detected) {
+                    this->rcon->send_command("kick " + number + " " + this->kick_message_vpn);
+                }
+            });
+        }
+        catch (std::exception& e) {
+            WARNING("Skipped vpn check of " + info.guid + ": " + e.what());
+        }
 
     }
 }
@@ -0,0 +1,44 @@
+#include <database/BloomFilter.hpp>
+
+#include <functional>
+#include <algorithm>
+
+BloomFilter::BloomFilter(size_t expectedKeys) {
+    size_t wordCount = std::max<size_t>((expectedKeys * bitsPerKey + 63) / 64, 1);
+    this->bitCount = wordCount * 64;
+    this->words = std::make_unique<std::atomic<uint64_t>[]>(wordCount);
+    for (size_t i = 0; i < wordCount; ++i) {
+        this->words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::pair<uint64_t, uint64_t> BloomFilter::__hash(const std::string& key) {
+    uint64_t h1 = std::hash<std::string>{}(key);
+
+    // splitmix64 finalizer, the second hash must not correlate with the first one
+    uint64_t h2 = h1 + 0x9E3779B97F4A7C15ull;
+    h2 = (h2 ^ (h2 >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h2 = (h2 ^ (h2 >> 27)) * 0x94D049BB133111EBull;
+    h2 = h2 ^ (h2 >> 31);
+
+    return { h1, h2 | 1 };
+}
+
+void BloomFilter::add(const std::string& key) {
+    auto h = __hash(key);
+    for (unsigned int i = 0; i < probes; ++i) {
+        size_t bit = static_cast<size_t>((h.first + i * h.second) % this->bitCount);
+        this->words[bit / 64].fetch_or(static_cast<uint64_t>(1) << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+bool BloomFilter::mayContain(const std::string& key) const {
+    auto h = __hash(key);
+    for (unsigned int i = 0; i < probes; ++i) {
+        size_t bit = static_cast<size_t>((h.first + i * h.second) % this->bitCount);
+        if ((this->words[bit / 64].load(std::memory_order_relaxed) & (static_cast<uint64_t>(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,548 @@
+#include <database/DBCache.hpp>
+
+#include <cstring>
+
+void DBCache::Segment::pushFront(Item* item) {
+    item->second.prev = nullptr;
+    item->second.next = this->head;
+    if (this->head) {
+        this->head->second.prev = item;
+    }
+    else {
+        this->tail = item;
+    }
+    this->head = item;
+}
+
+void DBCache::Segment::unlink(Item* item) {
+    if (item->second.prev) {
+        item->second.prev->second.next = item->second.next;
+    }
+    else {
+        this->head = item->second.next;
+    }
+    if (item->second.next) {
+        item->second.next->second.prev = item->second.prev;
+    }
+    else {
+        this->tail = item->second.prev;
+    }
+    item->second.prev = nullptr;
+    item->second.next = nullptr;
+}
+
+DBCache::DBCache(size_t maxBytes, size_t shardCount, int negativeTtl) : negativeTtl(negativeTtl) {
+    size_t count = 1;
+    while (count < shardCount) {
+        count <<= 1;
+    }
+    this->shards = std::make_unique<Shard[]>(count);
+    this->shardMask = count - 1;
+
+    if (maxBytes != 0) {
+        // every shard gets an equal share, keys are evenly spread by the hash
+        size_t shardBytes = std::max<size_t>(maxBytes / count, 1);
+        for (size_t i = 0; i < count; ++i) {
+            this->shards[i].maxBytes = shardBytes;
+        }
+    }
+}
+
+DBCache::~DBCache() {
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        __clear(this->shards[i]);
+    }
+}
+
+int DBCache::now() {
+    return static_cast<int>(utils::sysclock::to_time_t(utils::sysclock::now()));
+}
+
+void DBCache::__touch(Shard& shard, const std::string& key) {
+    // decided under the shard lock, a write right after finishWarmup passed the shard must not leave a dirty key behind
+    if (shard.warming) {
+        shard.dirtyKeys.insert(key);
+    }
+    if (shard.filtered) {
+        this->keyFilter->add(key);
+    }
+    shard.absentKeys.erase(key);
+}
+
+void DBCache::__putAbsent(Shard& shard, const std::string& key) {
+    if (this->negativeTtl <= 0) return;
+
+    // full -> not remembered, the expiry tick makes room again
+    if (shard.absentKeys.size() >= maxAbsentKeysPerShard && shard.absentKeys.find(key) == shard.absentKeys.end()) {
+        return;
+    }
+    shard.absentKeys[key] = now() + this->negativeTtl;
+}
+
+void DBCache::__schedule(Shard& shard, Item* item) {
+    if (item->second.expiry >= 0) {
+        shard.expiryWheel.schedule(item, item->second.expiry);
+    }
+    else {
+        shard.expiryWheel.cancel(item);
+    }
+}
+
+DBCache::EntryMap::iterator DBCache::__find(Shard& shard, const std::string& key) {
+    CacheKey lookup;
+    if (!shard.prefixes.find(key, lookup)) {
+        return shard.entries.end();
+    }
+    return shard.entries.find(lookup);
+}
+
+void DBCache::__put(Shard& shard, const std::string& key, std::string_view value, int expiry) {
+    auto it = __find(shard, key);
+
+    if (it == shard.entries.end()) {
+        // key suffix is copied into the arena, the map key points to it
+        CacheKey stored = shard.prefixes.intern(key);
+        char* suffix = shard.arena.allocate(stored.suffixSize);
+        if (stored.suffixSize > 0) {
+            std::memcpy(suffix, stored.suffix, stored.suffixSize);
+        }
+        stored.suffix = suffix;
+
+        it = shard.entries.emplace(stored, Entry{ nullptr, 0, expiry }).first;
+        shard.probation.pushFront(&*it);
+    }
+    else {
+        size_t oldBytes = __entryBytes(*it);
+        shard.usedBytes -= oldBytes;
+        if (it->second.isProtected) {
+            shard.protectedBytes -= oldBytes;
+        }
+        it->second.expiry = expiry;
+    }
+
+    Entry& entry = it->second;
+    // same size class -> the old block is reused
+    if (SlabArena::blockSize(entry.valueSize) != SlabArena::blockSize(value.size())) {
+        shard.arena.release(entry.value, entry.valueSize);
+        entry.value = shard.arena.allocate(value.size());
+    }
+    if (!value.empty()) {
+        std::memcpy(entry.value, value.data(), value.size());
+    }
+    entry.valueSize = static_cast<uint32_t>(value.size());
+
+    size_t bytes = __entryBytes(*it);
+    shard.usedBytes += bytes;
+    if (entry.isProtected) {
+        shard.protectedBytes += bytes;
+    }
+
+    __schedule(shard, &*it);
+}
+
+void DBCache::__erase(Shard& shard, EntryMap::iterator it) {
+    shard.expiryWheel.cancel(&*it);
+
+    size_t bytes = __entryBytes(*it);
+    if (it->second.isProtected) {
+        shard.protectedSegment.unlink(&*it);
+        shard.protectedBytes -= bytes;
+        --shard.protectedCount;
+    }
+    else {
+        shard.probation.unlink(&*it);
+    }
+    shard.usedBytes -= bytes;
+
+    shard.arena.release(it->second.value, it->second.valueSize);
+    char* suffix = const_cast<char*>(it->first.suffix);
+    uint32_t suffixSize = it->first.suffixSize;
+    shard.entries.erase(it);
+    shard.arena.release(suffix, suffixSize);
+}
+
+void DBCache::__promote(Shard& shard, EntryMap::iterator it) {
+    Item* item = &*it;
+    it->second.promotedAt = ++shard.promotions;
+
+    if (it->second.isProtected) {
+        shard.protectedSegment.unlink(item);
+        shard.protectedSegment.pushFront(item);
+        return;
+    }
+
+    shard.probation.unlink(item);
+    shard.protectedSegment.pushFront(item);
+    it->second.isProtected = true;
+    shard.protectedBytes += __entryBytes(*item);
+    ++shard.protectedCount;
+
+    if (shard.maxBytes == 0) return;
+
+    // protected segment full -> its tail gets another chance in probation
+    size_t maxProtected = shard.maxBytes / 5 * 4;
+    while (shard.protectedBytes > maxProtected && shard.protectedSegment.tail != shard.protectedSegment.head) {
+        Item* demoted = shard.protectedSegment.tail;
+        shard.protectedSegment.unlink(demoted);
+        shard.probation.pushFront(demoted);
+        demoted->second.isProtected = false;
+        shard.protectedBytes -= __entryBytes(*demoted);
+        --shard.protectedCount;
+    }
+}
+
+bool DBCache::__needsPromotion(const Shard& shard, const Entry& entry) {
+    if (shard.maxBytes == 0) return false;
+    if (!entry.isProtected) return true;
+    if (shard.promotions - entry.promotedAt <= shard.protectedCount / 4) return false;
+
+    static thread_local uint32_t sample = 0;
+    return (++sample & 3) == 0;
+}
+
+void DBCache::__evict(Shard& shard) {
+    if (shard.maxBytes == 0) return;
+
+    while (__bytes(shard) > shard.maxBytes && !shard.entries.empty()) {
+        Item* victim = shard.probation.tail ? shard.probation.tail : shard.protectedSegment.tail;
+        __erase(shard, shard.entries.find(victim->first));
+        ++this->evictions;
+        // the evicted key still exists, a miss is not final anymore
+        shard.complete = false;
+        shard.truncated = true;
+    }
+}
+
+void DBCache::__clear(Shard& shard) {
+    // large values are separate allocations, the rest goes with the arena chunks
+    for (auto& x : shard.entries) {
+        shard.arena.release(x.second.value, x.second.valueSize);
+        shard.arena.release(const_cast<char*>(x.first.suffix), x.first.suffixSize);
+    }
+    shard.entries.clear();
+    shard.arena.clear();
+    shard.probation = Segment();
+    shard.protectedSegment = Segment();
+    shard.usedBytes = 0;
+    shard.protectedBytes = 0;
+    shard.protectedCount = 0;
+    shard.promotions = 0;
+    shard.warming = false;
+    shard.dirtyKeys.clear();
+    shard.expiryWheel.reset(now());
+    shard.absentKeys.clear();
+    shard.complete = false;
+    shard.filtered = false;
+    shard.truncated = false;
+}
+
+std::optional<std::pair<std::string, int>> DBCache::get(const std::string& key, size_t maxSize) {
+    if (this->state.load() != State::WARM) return std::nullopt;
+
+    // never written -> no need to look into the shard
+    if (this->keyFilter && !this->keyFilter->mayContain(key)) {
+        ++this->misses;
+        return std::nullopt;
+    }
+
+    Shard& shard = this->__shardOf(key);
+    std::optional<std::pair<std::string, int>> ret;
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        if (this->__lookup(shard, key, maxSize, false, ret)) return ret;
+    }
+
+    // the entry has to move, looked up again as it may have changed in between
+    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+    this->__lookup(shard, key, maxSize, true, ret);
+    return ret;
+}
+
+bool DBCache::__lookup(Shard& shard, const std::string& key, size_t maxSize, bool promote, std::optional<std::pair<std::string, int>>& out) {
+    auto it = __find(shard, key);
+    if (it == shard.entries.end()) {
+        ++this->misses;
+        return true;
+    }
+
+    int ttl = -1;
+    if (it->second.expiry >= 0) {
+        ttl = it->second.expiry - now();
+        if (ttl <= 0) {
+            // expired
+            ++this->misses;
+            return true;
+        }
+    }
+
+    if (promote) {
+        __promote(shard, it);
+    }
+    else if (__needsPromotion(shard, it->second)) {
+        return false;
+    }
+
+    // cached, but too big for the output
+    if (it->second.valueSize > maxSize) return true;
+
+    ++this->hits;
+    out.emplace(std::string(it->second.value, it->second.valueSize), ttl);
+    return true;
+}
+
+bool DBCache::isAbsent(const std::string& key) {
+    if (this->state.load() != State::WARM) return false;
+
+    if (this->keyFilter && !this->keyFilter->mayContain(key)) {
+        ++this->negativeHits;
+        return true;
+    }
+
+    Shard& shard = this->__shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+    // cached (maybe expired or too big for the output), the database has to answer
+    if (__find(shard, key) != shard.entries.end()) {
+        return false;
+    }
+
+    if (shard.complete) {
+        ++this->negativeHits;
+        return true;
+    }
+
+    auto it = shard.absentKeys.find(key);
+    if (it != shard.absentKeys.end() && it->second > now()) {
+        ++this->negativeHits;
+        return true;
+    }
+
+    return false;
+}
+
+void DBCache::noteAbsent(const std::string& key, uint64_t token) {
+    if (this->negativeTtl <= 0 || this->state.load() != State::WARM) return;
+
+    Shard& shard = this->__shardOf(key);
+    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+
+    // written since the read was issued, the result may be outdated
+    if (this->__writeSeqOf(key).load() != token) {
+        return;
+    }
+    if (__find(shard, key) != shard.entries.end()) {
+        return;
+    }
+    this->__putAbsent(shard, key);
+}
+
+void DBCache::set(const std::string& key, const std::string& value, int ttl) {
+    ++this->__writeSeqOf(key);
+    if (this->state.load() == State::COLD) return;
+
+    int expiry = ttl < 0 ? -1 : now() + ttl;
+
+    Shard& shard = this->__shardOf(key);
+    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+    this->__touch(shard, key);
+    this->__put(shard, key, value, expiry);
+    this->__evict(shard);
+}
+
+void DBCache::expire(const std::string& key, int ttl) {
+    ++this->__writeSeqOf(key);
+    if (this->state.load() == State::COLD) return;
+
+    Shard& shard = this->__shardOf(key);
+    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+    this->__touch(shard, key);
+
+    if (ttl <= 0) {
+        this->__putAbsent(shard, key);
+    }
+
+    auto it = __find(shard, key);
+    if (it == shard.entries.end()) return;
+
+    if (ttl <= 0) {
+        __erase(shard, it);
+    }
+    else {
+        it->second.expiry = now() + ttl;
+        __schedule(shard, &*it);
+    }
+}
+
+void DBCache::del(const std::string& key) {
+    ++this->__writeSeqOf(key);
+    if (this->state.load() == State::COLD) return;
+
+    Shard& shard = this->__shardOf(key);
+    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+    this->__touch(shard, key);
+
+    auto it = __find(shard, key);
+    if (it != shard.entries.end()) {
+        __erase(shard, it);
+    }
+    this->__putAbsent(shard, key);
+}
+
+void DBCache::invalidate(const std::string& key) {
+    ++this->__writeSeqOf(key);
+    if (this->state.load() == State::COLD) return;
+
+    Shard& shard = this->__shardOf(key);
+    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+    this->__touch(shard, key);
+
+    auto it = __find(shard, key);
+    if (it != shard.entries.end()) {
+        __erase(shard, it);
+    }
+    // the key may exist without being cached, a miss in this shard is not final anymore
+    shard.complete = false;
+    shard.truncated = true;
+}
+
+void DBCache::beginWarmup() {
+    this->warmupStart = utils::sysclock::now();
+    this->warmupMs = -1;
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        std::lock_guard<std::shared_mutex> lock(this->shards[i].mutex);
+        this->shards[i].warming = true;
+    }
+    this->state = State::WARMING;
+}
+
+bool DBCache::loadWarmup(std::vector<DBKeyEntry>&& loaded) {
+    int loadTime = now();
+
+    // group by shard first, so every shard is locked only once
+    std::vector<std::vector<DBKeyEntry*>> perShard(this->__shardCount());
+    for (auto& x : loaded) {
+        perShard[std::hash<std::string>{}(x.first) & this->shardMask].push_back(&x);
+    }
+
+    bool room = true;
+    for (size_t i = 0; i < perShard.size(); ++i) {
+        if (perShard[i].empty()) continue;
+
+        Shard& shard = this->shards[i];
+        std::lock_guard<std::shared_mutex> lock(shard.mutex);
+
+        for (auto x : perShard[i]) {
+            // written during the warm-up -> the cache already has the newer state
+            if (shard.dirtyKeys.find(x->first) != shard.dirtyKeys.end()) {
+                continue;
+            }
+            this->__put(shard, x->first, x->second.first, x->second.second >= 0 ? x->second.second + loadTime : -1);
+
+            // budget of the shard reached: the entry that went over is taken out again, the rest is read from the db on demand
+            if (shard.maxBytes != 0 && __bytes(shard) > shard.maxBytes) {
+                __erase(shard, __find(shard, x->first));
+                this->__evict(shard);
+                shard.truncated = true;
+                room = false;
+                break;
+            }
+        }
+    }
+
+    return room;
+}
+
+void DBCache::finishWarmup(bool complete) {
+    if (complete) {
+        size_t keys = 0;
+        for (size_t i = 0; i < this->__shardCount(); ++i) {
+            std::lock_guard<std::shared_mutex> lock(this->shards[i].mutex);
+            keys += this->shards[i].entries.size() + this->shards[i].dirtyKeys.size();
+        }
+        // twice the loaded keys leaves room for new keys before the false positive rate goes up
+        this->keyFilter = std::make_unique<BloomFilter>(std::max<size_t>(keys * 2, 64 * 1024));
+    }
+
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        Shard& shard = this->shards[i];
+        std::lock_guard<std::shared_mutex> lock(shard.mutex);
+
+        // the filter and "a miss is final" are only sound if every key of the database was seen
+        if (complete) {
+            for (auto& x : shard.entries) {
+                this->keyFilter->add(shard.prefixes.toString(x.first));
+            }
+            for (auto& key : shard.dirtyKeys) {
+                this->keyFilter->add(key);
+            }
+            shard.filtered = true;
+            shard.complete = !shard.truncated;
+        }
+
+        shard.warming = false;
+        shard.dirtyKeys.clear();
+    }
+
+    this->warmupMs = utils::mili_seconds_since(this->warmupStart);
+    this->state = State::WARM;
+}
+
+void DBCache::failWarmup() {
+    this->state = State::COLD;
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        std::lock_guard<std::shared_mutex> lock(this->shards[i].mutex);
+        __clear(this->shards[i]);
+    }
+}
+
+size_t DBCache::evictExpired() {
+    size_t count = 0;
+    int time = now();
+
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        Shard& shard = this->shards[i];
+        std::lock_guard<std::shared_mutex> lock(shard.mutex);
+        shard.expiryWheel.advance(time, [&shard, &count](Item* item) {
+            __erase(shard, shard.entries.find(item->first));
+            ++count;
+        });
+
+        for (auto it = shard.absentKeys.begin(); it != shard.absentKeys.end();) {
+            if (it->second <= time) {
+                it = shard.absentKeys.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    this->expired += count;
+    return count;
+}
+
+size_t DBCache::size() {
+    size_t count = 0;
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        std::shared_lock<std::shared_mutex> lock(this->shards[i].mutex);
+        count += this->shards[i].entries.size();
+    }
+    return count;
+}
+
+DBCache::Stats DBCache::getStats() {
+    Stats stats{ this->hits.load(), this->misses.load(), this->evictions.load(), this->expired.load(), 0, 0, 0, 0, this->negativeHits.load(), 0, 0 };
+    for (size_t i = 0; i < this->__shardCount(); ++i) {
+        Shard& shard = this->shards[i];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        stats.keys += shard.entries.size();
+        stats.bytes += __bytes(shard);
+        stats.reservedBytes += shard.arena.reservedBytes() + shard.mapBytes;
+        stats.prefixes += shard.prefixes.size();
+        stats.negativeKeys += shard.absentKeys.size();
+        if (shard.filtered && this->keyFilter) {
+            stats.filterBytes = this->keyFilter->sizeInBytes();
+        }
+    }
+    return stats;
+}
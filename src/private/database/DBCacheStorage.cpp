@@ -0,0 +1,141 @@
+#include <database/DBCacheStorage.hpp>
+
+#include <limits>
+
+size_t SlabArena::__classOf(size_t size) {
+    if (size <= smallLimit) {
+        return (size + smallStep - 1) / smallStep - 1;
+    }
+
+    // size in (2^bits, 2^(bits+1)], split into four steps of 2^(bits-2)
+    size_t bits = 7;
+    while ((static_cast<size_t>(1) << (bits + 1)) < size) {
+        ++bits;
+    }
+    size_t step = static_cast<size_t>(1) << (bits - 2);
+    size_t sub = (size - (static_cast<size_t>(1) << bits) + step - 1) / step;
+    return smallLimit / smallStep + (bits - 7) * 4 + sub - 1;
+}
+
+size_t SlabArena::__classSize(size_t sizeClass) {
+    if (sizeClass < smallLimit / smallStep) {
+        return (sizeClass + 1) * smallStep;
+    }
+
+    size_t large = sizeClass - smallLimit / smallStep;
+    size_t bits = 7 + large / 4;
+    return (static_cast<size_t>(1) << bits) + (large % 4 + 1) * (static_cast<size_t>(1) << (bits - 2));
+}
+
+size_t SlabArena::blockSize(size_t size) {
+    if (size == 0) return 0;
+    if (size > maxBlock) return size;
+    return __classSize(__classOf(size));
+}
+
+char* SlabArena::allocate(size_t size) {
+    if (size == 0) return nullptr;
+
+    if (size > maxBlock) {
+        this->largeBytes += size;
+        return new char[size];
+    }
+
+    size_t sizeClass = __classOf(size);
+    FreeBlock*& freeList = this->freeLists[sizeClass];
+    if (freeList) {
+        char* block = reinterpret_cast<char*>(freeList);
+        freeList = freeList->next;
+        return block;
+    }
+
+    size_t bytes = __classSize(sizeClass);
+    if (static_cast<size_t>(this->chunkEnd - this->chunkPos) < bytes) {
+        // the rest of the old chunk is smaller than every block that is still needed from it, it is wasted
+        this->chunks.emplace_back(new char[chunkSize]);
+        this->chunkPos = this->chunks.back().get();
+        this->chunkEnd = this->chunkPos + chunkSize;
+    }
+
+    char* block = this->chunkPos;
+    this->chunkPos += bytes;
+    return block;
+}
+
+void SlabArena::release(char* block, size_t size) {
+    if (!block) return;
+
+    if (size > maxBlock) {
+        this->largeBytes -= size;
+        delete[] block;
+        return;
+    }
+
+    FreeBlock* freeBlock = reinterpret_cast<FreeBlock*>(block);
+    FreeBlock*& freeList = this->freeLists[__classOf(size)];
+    freeBlock->next = freeList;
+    freeList = freeBlock;
+}
+
+void SlabArena::clear() {
+    this->chunks.clear();
+    this->chunkPos = nullptr;
+    this->chunkEnd = nullptr;
+    for (auto& freeList : this->freeLists) {
+        freeList = nullptr;
+    }
+}
+
+CacheKey PrefixTable::intern(const std::string& key) {
+    auto pos = key.find(':');
+    if (pos == std::string::npos) {
+        return CacheKey{ key.data(), static_cast<uint32_t>(key.size()), 0 };
+    }
+
+    std::string_view prefix(key.data(), pos);
+    auto it = this->ids.find(prefix);
+    if (it == this->ids.end()) {
+        if (this->prefixes.size() > std::numeric_limits<uint16_t>::max()) {
+            // out of ids, keep the whole key
+            return CacheKey{ key.data(), static_cast<uint32_t>(key.size()), 0 };
+        }
+        this->prefixes.emplace_back(prefix);
+        it = this->ids.emplace(this->prefixes.back(), static_cast<uint16_t>(this->prefixes.size() - 1)).first;
+    }
+
+    return CacheKey{ key.data() + pos + 1, static_cast<uint32_t>(key.size() - pos - 1), it->second };
+}
+
+bool PrefixTable::find(const std::string& key, CacheKey& out) const {
+    auto pos = key.find(':');
+    if (pos == std::string::npos) {
+        out = CacheKey{ key.data(), static_cast<uint32_t>(key.size()), 0 };
+        return true;
+    }
+
+    auto it = this->ids.find(std::string_view(key.data(), pos));
+    if (it == this->ids.end()) {
+        if (this->prefixes.size() > std::numeric_limits<uint16_t>::max()) {
+            out = CacheKey{ key.data(), static_cast<uint32_t>(key.size()), 0 };
+            return true;
+        }
+        return false;
+    }
+
+    out = CacheKey{ key.data() + pos + 1, static_cast<uint32_t>(key.size() - pos - 1), it->second };
+    return true;
+}
+
+std::string PrefixTable::toString(const CacheKey& key) const {
+    if (key.prefix == 0) {
+        return std::string(key.suffixView());
+    }
+
+    const std::string& prefix = this->prefixes[key.prefix];
+    std::string out;
+    out.reserve(prefix.size() + 1 + key.suffixSize);
+    out += prefix;
+    out += ':';
+    out += key.suffixView();
+    return out;
+}
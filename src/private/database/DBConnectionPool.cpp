@@ -0,0 +1,393 @@
+#include <database/DBConnectionPool.hpp>
+#include <database/MySQLConnector.hpp>
+#include <database/RedisConnector.hpp>
+#include <database/SQLiteConnector.hpp>
+
+#include <algorithm>
+#include <future>
+
+using namespace std::literals::string_literals;
+
+DBConnectionPool::Lease::~Lease() {
+    if (this->pool && this->connector) {
+        this->pool->__giveBack(std::move(this->connector), this->suspect);
+    }
+}
+
+DBConnectionPool::DBConnectionPool(const DBConfig& dbConfig, Executor& executor, size_t minSize, size_t maxSize, std::chrono::seconds idleTimeout, std::chrono::milliseconds checkoutTimeout) :
+    dbConfig(dbConfig),
+    minSize(minSize),
+    maxSize(std::max<size_t>(maxSize, 1)),
+    idleTimeout(idleTimeout),
+    checkoutTimeout(checkoutTimeout)
+{
+    this->minSize = std::min(this->minSize, this->maxSize);
+
+    this->__preconnect(executor);
+
+    this->maintenance = std::thread(&DBConnectionPool::__runMaintenance, this);
+}
+
+DBConnectionPool::~DBConnectionPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->maintenanceCv.notify_all();
+    this->returned.notify_all();
+    if (this->maintenance.joinable()) {
+        this->maintenance.join();
+    }
+    this->idle.clear();
+}
+
+void DBConnectionPool::__preconnect(Executor& executor) {
+    auto start = utils::sysclock::now();
+
+    // the first connection checks the config and creates schema / table if needed,
+    // a broken config fails here and the others do not race on the setup
+    DBConRef first = this->__connect();
+    this->shared = first->isShareable();
+    auto now = utils::sysclock::now();
+    this->idle.push_back({ std::move(first), now, now });
+    this->open = 1;
+
+    std::vector<std::future<DBConRef>> pending;
+    pending.reserve(this->minSize);
+    for (size_t i = 1; i < this->minSize; ++i) {
+        pending.emplace_back(executor.enqueue([this]() {
+            return this->__connect();
+        }));
+    }
+
+    now = utils::sysclock::now();
+    for (auto& x : pending) {
+        try {
+            this->idle.push_back({ x.get(), now, now });
+            ++this->open;
+        }
+        catch (std::exception& e) {
+            // the maintenance tops the pool up later
+            WARNING("Opening a connection of " + this->dbConfig.connectionName + " failed: " + e.what());
+        }
+    }
+
+    INFO("Opened " + std::to_string(this->open) + " connections of " + this->dbConfig.connectionName +
+        " in " + std::to_string(utils::mili_seconds_since(start)) + "ms (slowest connect " +
+        std::to_string(this->maxConnectMicros.load() / 1000) + "ms)");
+}
+
+DBConRef DBConnectionPool::__connect() {
+    auto start = utils::sysclock::now();
+    DBConRef connector;
+    try {
+        switch (this->dbConfig.dbType) {
+            case DBType::MY_SQL: {
+                connector = std::make_shared<MySQLConnector>(this->dbConfig);
+                break;
+            }
+            case DBType::SQLITE: {
+                connector = std::make_shared<SQLiteConnector>(this->dbConfig);
+                break;
+            }
+            case DBType::REDIS: {
+                connector = std::make_shared<RedisConnector>(this->dbConfig);
+                break;
+            }
+            default: {
+                WARNING("Unknown Database type");
+                break;
+            }
+        };
+    }
+    catch (const std::runtime_error& e) {
+        WARNING("Runtime Error during connector creation: "s + e.what());
+        throw std::runtime_error("Could not create database connector");
+    }
+    if (!connector) {
+        WARNING("Database connector could not be created");
+        throw std::runtime_error("Database connector could not be created");
+    }
+
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(utils::sysclock::now() - start).count());
+    this->connectMicros += micros;
+    __recordMax(this->maxConnectMicros, micros);
+
+    ++this->created;
+    return connector;
+}
+
+bool DBConnectionPool::__isHealthy(const DBConRef& connector) {
+    try {
+        auto result = connector->ping();
+        return result == "1" || result == "true";
+    }
+    catch (std::exception& e) {
+        return false;
+    }
+}
+
+DBConnectionPool::Lease DBConnectionPool::checkout() {
+    auto start = utils::sysclock::now();
+    auto deadline = start + this->checkoutTimeout;
+    bool waited = false;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        if (this->stop) {
+            throw std::runtime_error("Connection pool of " + this->dbConfig.connectionName + " is closed");
+        }
+
+        if (this->shared && !this->idle.empty()) {
+            DBConRef connector = this->idle[this->nextShared++ % this->idle.size()].connector;
+            lock.unlock();
+            this->__recordWait(start, waited);
+            return Lease(this, std::move(connector));
+        }
+
+        if (!this->idle.empty()) {
+            DBConRef connector = std::move(this->idle.back().connector);
+            this->idle.pop_back();
+            lock.unlock();
+            this->__recordWait(start, waited);
+            return Lease(this, std::move(connector));
+        }
+
+        if (this->open < this->maxSize) {
+            // slot is reserved, the connect itself runs without the lock
+            ++this->open;
+            lock.unlock();
+            try {
+                DBConRef connector = this->__connect();
+                if (this->shared) {
+                    auto now = utils::sysclock::now();
+                    lock.lock();
+                    this->idle.push_back({ connector, now, now });
+                    this->returned.notify_all();
+                    lock.unlock();
+                }
+                this->__recordWait(start, waited);
+                return Lease(this, std::move(connector));
+            }
+            catch (...) {
+                lock.lock();
+                --this->open;
+                ++this->closed;
+                this->returned.notify_one();
+                throw;
+            }
+        }
+
+        waited = true;
+        if (this->returned.wait_until(lock, deadline) == std::cv_status::timeout && this->idle.empty() && this->open >= this->maxSize) {
+            lock.unlock();
+            this->__recordWait(start, waited);
+            throw std::runtime_error("Timed out waiting for a connection of " + this->dbConfig.connectionName);
+        }
+    }
+}
+
+DBConnectionPool::Lease DBConnectionPool::tryCheckout() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (this->stop) {
+        throw std::runtime_error("Connection pool of " + this->dbConfig.connectionName + " is closed");
+    }
+
+    if (this->shared && !this->idle.empty()) {
+        DBConRef connector = this->idle[this->nextShared++ % this->idle.size()].connector;
+        lock.unlock();
+        ++this->checkouts;
+        return Lease(this, std::move(connector));
+    }
+
+    if (!this->shared && !this->idle.empty()) {
+        DBConRef connector = std::move(this->idle.back().connector);
+        this->idle.pop_back();
+        lock.unlock();
+        ++this->checkouts;
+        return Lease(this, std::move(connector));
+    }
+
+    this->wanted = true;
+    lock.unlock();
+    this->maintenanceCv.notify_all();
+    throw std::runtime_error("No connection of " + this->dbConfig.connectionName + " is ready");
+}
+
+void DBConnectionPool::__giveBack(DBConRef&& connector, bool suspect) {
+    if (this->shared) {
+        // never left the pool, only a dead one is taken out
+        if (suspect && !__isHealthy(connector)) {
+            this->__dropShared(connector);
+        }
+        return;
+    }
+
+    if (suspect && !__isHealthy(connector)) {
+        ++this->unhealthy;
+        ++this->closed;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        --this->open;
+        this->returned.notify_one();
+        return;
+    }
+
+    auto now = utils::sysclock::now();
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->idle.push_back({ std::move(connector), now, now });
+    this->returned.notify_one();
+}
+
+void DBConnectionPool::__dropShared(const DBConRef& connector) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = std::find_if(this->idle.begin(), this->idle.end(), [&connector](const IdleConnector& x) {
+        return x.connector == connector;
+    });
+    // may have been dropped by another caller already
+    if (it == this->idle.end()) return;
+
+    this->idle.erase(it);
+    --this->open;
+    ++this->unhealthy;
+    ++this->closed;
+    this->returned.notify_one();
+}
+
+void DBConnectionPool::__recordWait(const utils::timestamp& start, bool waited) {
+    ++this->checkouts;
+    if (!waited) return;
+
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(utils::sysclock::now() - start).count());
+    ++this->waits;
+    this->waitMicros += micros;
+
+    __recordMax(this->maxWaitMicros, micros);
+}
+
+void DBConnectionPool::__recordMax(std::atomic<uint64_t>& max, uint64_t value) {
+    uint64_t current = max.load();
+    while (value > current && !max.compare_exchange_weak(current, value)) {}
+}
+
+void DBConnectionPool::__runMaintenance() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->stop) {
+        this->maintenanceCv.wait_for(lock, maintenanceInterval);
+        if (this->stop) break;
+
+        lock.unlock();
+        try {
+            this->__maintain();
+        }
+        catch (std::exception& e) {
+            WARNING("Connection pool maintenance of " + this->dbConfig.connectionName + " failed: " + e.what());
+        }
+        lock.lock();
+    }
+}
+
+void DBConnectionPool::__maintain() {
+    auto now = utils::sysclock::now();
+    std::vector<IdleConnector> toClose;
+    std::vector<IdleConnector> toCheck;
+    std::vector<DBConRef> sharedToCheck;
+    size_t missing = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // oldest idle connections are at the front
+        size_t keep = 0;
+        for (auto& x : this->idle) {
+            // shared connections are never given back, their idle time says nothing
+            if (!this->shared && this->open > this->minSize && now - x.since > this->idleTimeout) {
+                toClose.emplace_back(std::move(x));
+                --this->open;
+            }
+            else if (!this->shared && now - x.lastCheck > healthCheckAfter) {
+                // still counted as open while it is checked
+                toCheck.emplace_back(std::move(x));
+            }
+            else {
+                if (this->shared && now - x.lastCheck > healthCheckAfter) {
+                    // stays in use while it is checked
+                    x.lastCheck = now;
+                    sharedToCheck.push_back(x.connector);
+                }
+                if (&this->idle[keep] != &x) {
+                    this->idle[keep] = std::move(x);
+                }
+                ++keep;
+            }
+        }
+        this->idle.resize(keep);
+
+        size_t target = std::max<size_t>(this->minSize, this->wanted ? 1 : 0);
+        this->wanted = false;
+        if (this->open < target) {
+            missing = target - this->open;
+            this->open += missing;
+        }
+    }
+
+    this->closed += toClose.size();
+    toClose.clear();
+
+    std::vector<IdleConnector> healthy;
+    size_t dead = 0;
+    for (auto& x : toCheck) {
+        if (__isHealthy(x.connector)) {
+            x.lastCheck = now;
+            healthy.emplace_back(std::move(x));
+        }
+        else {
+            ++dead;
+        }
+    }
+    toCheck.clear();
+    this->unhealthy += dead;
+    this->closed += dead;
+
+    for (auto& x : sharedToCheck) {
+        if (!__isHealthy(x)) {
+            this->__dropShared(x);
+        }
+    }
+
+    for (size_t i = 0; i < missing; ++i) {
+        try {
+            healthy.push_back({ this->__connect(), now, now });
+        }
+        catch (std::exception& e) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->open -= missing - i;
+            missing = i;
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->open -= dead;
+    // checked ones go to the front, they were idle the longest
+    this->idle.insert(this->idle.begin(), std::make_move_iterator(healthy.begin()), std::make_move_iterator(healthy.end()));
+    if (dead > 0 || !healthy.empty()) {
+        this->returned.notify_all();
+    }
+}
+
+DBConnectionPool::Stats DBConnectionPool::getStats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return Stats{
+        this->open,
+        this->idle.size(),
+        this->checkouts.load(),
+        this->waits.load(),
+        this->waitMicros.load(),
+        this->maxWaitMicros.load(),
+        this->created.load(),
+        this->closed.load(),
+        this->unhealthy.load(),
+        this->connectMicros.load(),
+        this->maxConnectMicros.load()
+    };
+}
@@ -1,2 +1,59 @@
 #include <database/DBConnector.hpp>
 
+#include <stdexcept>
+
+
+DBEntryPage DBConnector::scanEntries(const std::string& prefix, const std::string& cursor, size_t count) {
+    auto keys = this->scanKeys(prefix, cursor, count);
+
+    DBEntryPage ret;
+    ret.first = std::move(keys.first);
+    ret.second.reserve(keys.second.size());
+    for (auto& key : keys.second) {
+        auto entry = this->getWithTtl(key);
+        if (entry.second < 0) {
+            entry.second = -1;
+        }
+        ret.second.emplace_back(std::move(key), std::move(entry));
+    }
+    return ret;
+}
+
+std::vector<std::string> DBConnector::getMany(const std::vector<std::string>& keys) {
+    std::vector<std::string> ret;
+    ret.reserve(keys.size());
+    for (auto& key : keys) {
+        ret.emplace_back(this->get(key));
+    }
+    return ret;
+}
+
+bool DBConnector::setMany(const std::vector<DBKeyValue>& entries) {
+    bool ret = true;
+    for (auto& entry : entries) {
+        ret = this->set(entry.first, entry.second) && ret;
+    }
+    return ret;
+}
+
+bool DBConnector::setExMany(const std::vector<DBKeyEntry>& entries) {
+    bool ret = true;
+    for (auto& entry : entries) {
+        bool written = entry.second.second < 0 ?
+            this->set(entry.first, entry.second.first) :
+            this->setEx(entry.first, entry.second.second, entry.second.first);
+        ret = written && ret;
+    }
+    return ret;
+}
+
+#define ASYNC_NOT_SUPPORTED throw std::runtime_error("Async calls are not supported by this connector");
+
+void DBConnector::getAsync(const std::string& key, DBCompletion<std::string>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::getWithTtlAsync(const std::string& key, DBCompletion<std::pair<std::string, int>>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::existsAsync(const std::string& key, DBCompletion<bool>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::setAsync(const std::string& key, const std::string& value, DBCompletion<bool>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::setExAsync(const std::string& key, int ttl, const std::string& value, DBCompletion<bool>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::expireAsync(const std::string& key, int ttl, DBCompletion<bool>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::delAsync(const std::string& key, DBCompletion<bool>&& done) { ASYNC_NOT_SUPPORTED }
+void DBConnector::ttlAsync(const std::string& key, DBCompletion<int>&& done) { ASYNC_NOT_SUPPORTED }
@@ -18,7 +18,281 @@ WorkerRef DBManager::__getDbWorker(const std::string& name) {
     throw std::runtime_error("No worker found for name: " + name);
 }
 
+WriteBufferRef DBManager::__getDbWriteBuffer(const std::string& name) {
+    for (auto& x : this->dbWriteBuffers) {
+        if (x.first == name) {
+            return x.second;
+        }
+    }
+    return nullptr;
+}
+
+void DBManager::__onSet(const std::string& workerName, const std::string& key, const std::string& value, int ttl) {
+    if (auto cache = this->__getDbWorkerCache(workerName)) {
+        cache->set(key, value, ttl);
+    }
+    if (auto buffer = this->__getDbWriteBuffer(workerName)) {
+        buffer->drop(key);
+    }
+}
+
+void DBManager::__onSetMany(const std::string& workerName, const std::vector<DBKeyValue>& entries) {
+    auto cache = this->__getDbWorkerCache(workerName);
+    auto buffer = this->__getDbWriteBuffer(workerName);
+    for (auto& entry : entries) {
+        if (cache) cache->set(entry.first, entry.second, -1);
+        if (buffer) buffer->drop(entry.first);
+    }
+}
+
+void DBManager::__onSetMany(const std::string& workerName, const std::vector<DBKeyEntry>& entries) {
+    auto cache = this->__getDbWorkerCache(workerName);
+    auto buffer = this->__getDbWriteBuffer(workerName);
+    for (auto& entry : entries) {
+        if (cache) cache->set(entry.first, entry.second.first, entry.second.second < 0 ? -1 : entry.second.second);
+        if (buffer) buffer->drop(entry.first);
+    }
+}
+
+void DBManager::__onExpire(const std::string& workerName, const std::string& key, int ttl) {
+    if (auto cache = this->__getDbWorkerCache(workerName)) {
+        cache->expire(key, ttl);
+    }
+    if (auto buffer = this->__getDbWriteBuffer(workerName)) {
+        buffer->flushKey(key);
+    }
+}
+
+void DBManager::__onDel(const std::string& workerName, const std::string& key) {
+    if (auto cache = this->__getDbWorkerCache(workerName)) {
+        cache->del(key);
+    }
+    if (auto buffer = this->__getDbWriteBuffer(workerName)) {
+        buffer->drop(key);
+    }
+}
+
+void DBManager::__onRead(const std::string& workerName, const std::string& key) {
+    if (auto buffer = this->__getDbWriteBuffer(workerName)) {
+        buffer->flushKey(key);
+    }
+}
+
+bool DBManager::bufferWrite(const std::string& workerName, const std::string& key, const std::string& value, int ttl) {
+    auto buffer = this->__getDbWriteBuffer(workerName);
+    if (!buffer || !buffer->write(key, value, ttl)) {
+        return false;
+    }
+    if (auto cache = this->__getDbWorkerCache(workerName)) {
+        cache->set(key, value, ttl);
+    }
+    return true;
+}
+
+void DBManager::closeWriteBuffers() {
+    for (auto& x : this->dbWriteBuffers) {
+        if (x.second) {
+            x.second->close();
+        }
+    }
+}
+
+std::vector<std::pair<std::string, uint64_t>> DBManager::getStats() {
+    std::vector<std::pair<std::string, uint64_t>> stats;
+    for (auto& x : this->dbWorkerCaches) {
+        if (!x.second) continue;
+        auto s = x.second->getStats();
+        uint64_t lookups = s.hits + s.misses;
+        stats.emplace_back(x.first + ".cacheKeys", s.keys);
+        stats.emplace_back(x.first + ".cacheBytes", s.bytes);
+        stats.emplace_back(x.first + ".cacheBytesPerEntry", s.keys > 0 ? s.reservedBytes / s.keys : 0);
+        stats.emplace_back(x.first + ".cachePrefixes", s.prefixes);
+        stats.emplace_back(x.first + ".cacheHits", s.hits);
+        stats.emplace_back(x.first + ".cacheMisses", s.misses);
+        stats.emplace_back(x.first + ".cacheHitPermille", lookups > 0 ? s.hits * 1000 / lookups : 0);
+        stats.emplace_back(x.first + ".cacheEvicted", s.evictions);
+        stats.emplace_back(x.first + ".cacheExpired", s.expired);
+        stats.emplace_back(x.first + ".cacheNegativeHits", s.negativeHits);
+        stats.emplace_back(x.first + ".cacheNegativeKeys", s.negativeKeys);
+        stats.emplace_back(x.first + ".cacheFilterBytes", s.filterBytes);
+    }
+    for (auto& x : this->dbWorkers) {
+        auto s = x.second->getPoolStats();
+        stats.emplace_back(x.first + ".poolOpen", s.open);
+        stats.emplace_back(x.first + ".poolIdle", s.idle);
+        stats.emplace_back(x.first + ".poolCheckouts", s.checkouts);
+        stats.emplace_back(x.first + ".poolWaits", s.waits);
+        stats.emplace_back(x.first + ".poolWaitUsAvg", s.waits > 0 ? s.waitMicros / s.waits : 0);
+        stats.emplace_back(x.first + ".poolWaitUsMax", s.maxWaitMicros);
+        stats.emplace_back(x.first + ".poolCreated", s.created);
+        stats.emplace_back(x.first + ".poolClosed", s.closed);
+        stats.emplace_back(x.first + ".poolUnhealthy", s.unhealthy);
+        stats.emplace_back(x.first + ".poolConnectUsAvg", s.created > 0 ? s.connectMicros / s.created : 0);
+        stats.emplace_back(x.first + ".poolConnectUsMax", s.maxConnectMicros);
+        x.second->getExecutor().appendStats(stats, x.first);
+        auto b = x.second->getReadBatchStats();
+        stats.emplace_back(x.first + ".readBatches", b.batches);
+        stats.emplace_back(x.first + ".readBatchedKeys", b.reads);
+        stats.emplace_back(x.first + ".readBatchKeysAvg", b.batches > 0 ? b.reads / b.batches : 0);
+        stats.emplace_back(x.first + ".readBatchKeysMax", b.maxBatch);
+        auto a = x.second->getAsyncStats();
+        stats.emplace_back(x.first + ".asyncCalls", a.calls);
+        stats.emplace_back(x.first + ".asyncFailed", a.failed);
+        stats.emplace_back(x.first + ".asyncRejected", a.rejected);
+        stats.emplace_back(x.first + ".asyncInFlight", a.inFlight);
+        stats.emplace_back(x.first + ".asyncInFlightMax", a.maxInFlight);
+        stats.emplace_back(x.first + ".asyncUsAvg", a.completed > 0 ? a.micros / a.completed : 0);
+        stats.emplace_back(x.first + ".asyncUsMax", a.maxMicros);
+        stats.emplace_back(x.first + ".asyncTimedOut", a.timedOut);
+    }
+    for (auto& x : this->dbWriteBuffers) {
+        if (!x.second) continue;
+        auto s = x.second->getStats();
+        stats.emplace_back(x.first + ".writesBuffered", s.buffered);
+        stats.emplace_back(x.first + ".writesAbsorbed", s.absorbed);
+        stats.emplace_back(x.first + ".writesIssued", s.issued);
+        stats.emplace_back(x.first + ".writesFailed", s.failed);
+        stats.emplace_back(x.first + ".writesRejected", s.rejected);
+    }
+    return stats;
+}
+
+void DBManager::__runExpiry() {
+    std::unique_lock<std::mutex> lock(this->expiryMutex);
+    while (!this->stopExpiry) {
+        this->expiryCv.wait_for(lock, std::chrono::seconds(1));
+        if (this->stopExpiry) break;
+
+        lock.unlock();
+        for (auto& x : this->dbWorkerCaches) {
+            if (x.second && x.second->getState() == DBCache::State::WARM) {
+                x.second->evictExpired();
+            }
+        }
+        for (auto& x : this->dbWorkers) {
+            x.second->expireAsyncCalls();
+        }
+        lock.lock();
+    }
+}
+
+void DBManager::Warmups::stopAll() {
+    this->stop = true;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cv.wait(lock, [this]() { return this->running == 0; });
+}
+
+bool DBManager::__warmup(DBWorker& worker, const WorkerCacheRef& cache) {
+    struct Fill {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t pending = 0; /*!< pages handed to other threads */
+        bool full = false;
+        bool failed = false;
+    };
+    auto fill = std::make_shared<Fill>();
+
+    auto insert = [cache, fill](std::vector<DBKeyEntry>& entries) {
+        bool room = false;
+        bool failed = false;
+        try {
+            room = cache->loadWarmup(std::move(entries));
+        }
+        catch (...) {
+            failed = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(fill->mutex);
+            --fill->pending;
+            fill->full = fill->full || !room;
+            fill->failed = fill->failed || failed;
+        }
+        fill->cv.notify_all();
+    };
+
+    // this thread reads, the other threads insert. At most one page per inserting thread is held besides the cache
+    Executor& executor = worker.getExecutor();
+    size_t maxPending = executor.getThreadCount() - 1;
+
+    auto awaitPending = [&fill](size_t limit) {
+        std::unique_lock<std::mutex> lock(fill->mutex);
+        fill->cv.wait(lock, [&fill, limit]() { return fill->pending <= limit || (limit > 0 && fill->full); });
+        return !fill->full && !fill->failed;
+    };
+
+    std::string cursor;
+    bool stopped = false;
+    try {
+        do {
+            if (this->warmups.stop) {
+                stopped = true;
+                break;
+            }
+
+            auto page = worker.scanEntries("", cursor, 1000);
+            cursor = std::move(page.first);
+
+            if (!awaitPending(maxPending > 0 ? maxPending - 1 : 0)) {
+                stopped = true;
+                break;
+            }
+
+            auto entries = std::make_shared<std::vector<DBKeyEntry>>(std::move(page.second));
+            {
+                std::lock_guard<std::mutex> lock(fill->mutex);
+                ++fill->pending;
+            }
+            if (maxPending == 0) {
+                insert(*entries);
+                continue;
+            }
+            try {
+                executor.fireAndForget([insert, entries]() { insert(*entries); }, Executor::Priority::LOW);
+            }
+            catch (std::exception&) {
+                // queue full
+                insert(*entries);
+            }
+        } while (!cursor.empty());
+    }
+    catch (...) {
+        awaitPending(0);
+        throw;
+    }
+
+    bool inserted = awaitPending(0);
+    if (fill->failed) {
+        throw std::runtime_error("Cache insert failed");
+    }
+
+    // the load throws on errors, it is complete if it reached the last page within the budget
+    cache->finishWarmup(!stopped && inserted);
+    return !this->warmups.stop;
+}
+
+std::vector<DBManager::CacheStatus> DBManager::getCacheStatus() {
+    std::vector<CacheStatus> status;
+    for (auto& x : this->dbWorkerCaches) {
+        if (!x.second) continue;
+        status.emplace_back(CacheStatus{ x.first, x.second->getState(), x.second->size(), x.second->getWarmupMs() });
+    }
+    return status;
+}
+
+std::optional<std::pair<std::string, int>> DBManager::getCached(const std::string& workerName, const std::string& key, size_t maxSize) {
+    auto cache = this->__getDbWorkerCache(workerName);
+    if (!cache) return std::nullopt;
+
+    return cache->get(key, maxSize);
+}
+
+bool DBManager::isKnownAbsent(const std::string& workerName, const std::string& key) {
+    auto cache = this->__getDbWorkerCache(workerName);
+    return cache && cache->isAbsent(key);
+}
+
 DBManager::DBManager(const rapidjson::Value& cons) {
+
     for (auto& itr = cons.MemberBegin(); itr != cons.MemberEnd(); itr++ ) {
 
         std::string name = itr->name.GetString();
@@ -54,6 +328,11 @@ DBManager::DBManager(const rapidjson::Value& cons) {
             dbConf.ip = config.HasMember("ip") ? config["ip"].GetString() : "127.0.0.1";
             dbConf.port = config.HasMember("port") ? config["port"].GetInt() : 6379;
             dbConf.password = config.HasMember("password") ? config["password"].GetString() : "";
+            dbConf.redisAsync = config.HasMember("async") && config["async"].GetBool();
+            if (config.HasMember("asyncMaxInFlight")) dbConf.redisAsyncMaxInFlight = config["asyncMaxInFlight"].GetUint();
+            // replies can only be matched to their calls on a shared connection
+            dbConf.redisPipeline = dbConf.redisAsync || (config.HasMember("pipeline") && config["pipeline"].GetBool());
+            if (config.HasMember("replyTimeoutMs")) dbConf.redisReplyTimeoutMs = config["replyTimeoutMs"].GetInt();
         }
         else if (utils::iequals(type, "sqlite")) {
 
@@ -68,6 +347,27 @@ DBManager::DBManager(const rapidjson::Value& cons) {
 
         dbConf.connectionName = name;
 
+        if (config.HasMember("pool") && config["pool"].IsObject()) {
+            auto pool = config["pool"].GetObject();
+            if (pool.HasMember("min")) dbConf.poolMin = pool["min"].GetUint();
+            if (pool.HasMember("max")) dbConf.poolMax = pool["max"].GetUint();
+            if (pool.HasMember("idleTimeout")) dbConf.poolIdleTimeout = pool["idleTimeout"].GetInt();
+            if (pool.HasMember("checkoutTimeoutMs")) dbConf.poolCheckoutTimeoutMs = pool["checkoutTimeoutMs"].GetInt();
+        }
+
+        if (config.HasMember("executor") && config["executor"].IsObject()) {
+            auto executor = config["executor"].GetObject();
+            if (executor.HasMember("threads")) dbConf.executorThreads = executor["threads"].GetUint();
+            if (executor.HasMember("queueMax")) dbConf.executorQueueMax = executor["queueMax"].GetUint();
+            if (executor.HasMember("agingMs")) dbConf.executorAgingMs = executor["agingMs"].GetInt();
+        }
+
+        if (config.HasMember("readBatch") && config["readBatch"].IsObject()) {
+            auto readBatch = config["readBatch"].GetObject();
+            if (readBatch.HasMember("maxKeys")) dbConf.readBatchMax = readBatch["maxKeys"].GetUint();
+            if (readBatch.HasMember("windowUs")) dbConf.readBatchWindowUs = readBatch["windowUs"].GetInt();
+        }
+
         if (config.HasMember("statements") && config["statements"].IsObject()) {
             for (auto itr = config["statements"].MemberBegin(); itr != config["statements"].MemberEnd(); ++itr) {
                 std::string statementName = itr->name.GetString();
@@ -135,20 +435,46 @@ DBManager::DBManager(const rapidjson::Value& cons) {
 
         if (!config.HasMember("disableCache") || !config["disableCache"].GetBool()) {
 
-            std::vector<std::string> keys = std::get< std::vector<std::string> >( worker->keys<DBExecutionType::SYNC>("") );
-            DBEntryMap map;
-            map.reserve(std::min(keys.size() * 2, 1000u));
-
-            for (auto& x : keys) {
-                map.insert({ x, std::get< std::pair<std::string,int> >( worker->getWithTtl<DBExecutionType::SYNC>(std::move(x)) ) });
-            }
-
-            auto cacheref = std::make_shared<WorkerCache>();
-            cacheref->second = std::move(map);
-
+            // 0 = unbounded
+            size_t cacheMaxBytes = config.HasMember("cacheMaxBytes") ? config["cacheMaxBytes"].GetUint64() : 0;
+            // all executor threads and the game thread access the cache, twice as many shards keeps collisions rare
+            size_t cacheShards = (worker->getExecutor().getThreadCount() + 1) * 2;
+            // seconds a "not found" of the database is remembered, 0 disables it
+            int negativeTtl = config.HasMember("cacheNegativeTtl") ? config["cacheNegativeTtl"].GetInt() : 5;
+            auto cacheref = std::make_shared<DBCache>(cacheMaxBytes, cacheShards, negativeTtl);
+            worker->setCache(cacheref);
             this->dbWorkerCaches.emplace_back(
                 std::pair< std::string, WorkerCacheRef >(name, cacheref)
             );
+
+            // warm-up runs in the background, reads fall through to the db until the cache is warm
+            cacheref->beginWarmup();
+            {
+                std::lock_guard<std::mutex> lock(this->warmups.mutex);
+                ++this->warmups.running;
+            }
+            try {
+                worker->getExecutor().fireAndForget([this, name, rawWorker = worker.get(), cacheref]() {
+                    try {
+                        if (this->__warmup(*rawWorker, cacheref)) {
+                            INFO("Cache of " + name + " is warm: " + std::to_string(cacheref->size()) + " keys in " + std::to_string(cacheref->getWarmupMs()) + "ms");
+                        }
+                    }
+                    catch (std::exception& e) {
+                        cacheref->failWarmup();
+                        WARNING("Cache warm-up of " + name + " failed: " + e.what());
+                    }
+                    // notified under the lock, the destructor may free warmups as soon as running is 0
+                    std::lock_guard<std::mutex> lock(this->warmups.mutex);
+                    --this->warmups.running;
+                    this->warmups.cv.notify_all();
+                }, Executor::Priority::LOW);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(this->warmups.mutex);
+                --this->warmups.running;
+                throw;
+            }
         }
         else {
             this->dbWorkerCaches.emplace_back(
@@ -156,5 +482,34 @@ DBManager::DBManager(const rapidjson::Value& cons) {
             );
         }
 
+        WriteBufferRef writeBuffer = nullptr;
+        if (config.HasMember("writeBehind") && config["writeBehind"].IsObject()) {
+            auto writeBehind = config["writeBehind"].GetObject();
+            if (writeBehind.HasMember("enable") && writeBehind["enable"].GetBool()) {
+                int windowMs = writeBehind.HasMember("windowMs") ? writeBehind["windowMs"].GetInt() : 500;
+                size_t maxBytes = writeBehind.HasMember("maxBytes") ? writeBehind["maxBytes"].GetUint64() : 16 * 1024 * 1024;
+                writeBuffer = std::make_shared<DBWriteBuffer>(worker, std::chrono::milliseconds(windowMs), maxBytes);
+            }
+        }
+        this->dbWriteBuffers.emplace_back(
+            std::pair< std::string, WriteBufferRef >(name, writeBuffer)
+        );
+
+    }
+
+    this->expiryThread = std::thread(&DBManager::__runExpiry, this);
+}
+
+DBManager::~DBManager() {
+    // before the workers are released, a warm-up only holds a raw pointer to its worker
+    this->warmups.stopAll();
+
+    {
+        std::lock_guard<std::mutex> lock(this->expiryMutex);
+        this->stopExpiry = true;
+    }
+    this->expiryCv.notify_all();
+    if (this->expiryThread.joinable()) {
+        this->expiryThread.join();
     }
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <database/DBReadBatcher.hpp>
+
+#include <algorithm>
+
+DBReadBatcher::DBReadBatcher(Executor& executor, Fetch&& fetch, std::chrono::microseconds window, size_t maxBatch) :
+    executor(executor),
+    fetch(std::move(fetch)),
+    window(window),
+    maxBatch(std::max<size_t>(maxBatch, 1))
+{}
+
+void DBReadBatcher::add(std::string&& key, Completion&& done, Executor::Priority priority) {
+    std::shared_ptr<Batch> created;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->open) {
+            this->open = std::make_shared<Batch>();
+            this->open->reads.reserve(this->maxBatch);
+            this->open->openedAt = std::chrono::steady_clock::now();
+            created = this->open;
+        }
+        this->open->reads.push_back({ std::move(key), std::move(done) });
+        if (this->open->reads.size() >= this->maxBatch) {
+            this->open = nullptr;
+            this->closed.notify_all();
+        }
+    }
+    ++this->reads;
+
+    if (!created) return;
+
+    try {
+        this->executor.fireAndForget([this, created]() {
+            this->__run(created);
+        }, priority);
+    }
+    catch (...) {
+        // nobody will fetch this batch, the reads that joined it meanwhile fail
+        std::vector<PendingRead> joined;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->open == created) {
+                this->open = nullptr;
+            }
+            joined = std::move(created->reads);
+        }
+        for (size_t i = 1; i < joined.size(); ++i) {
+            joined[i].done(std::string(), true);
+        }
+        throw;
+    }
+}
+
+void DBReadBatcher::__run(const std::shared_ptr<Batch>& batch) {
+    std::vector<PendingRead> batchReads;
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->closed.wait_until(lock, batch->openedAt + this->window, [this, &batch]() {
+            return this->open != batch;
+        });
+        if (this->open == batch) {
+            this->open = nullptr;
+        }
+        batchReads = std::move(batch->reads);
+    }
+
+    std::vector<std::string> keys;
+    keys.reserve(batchReads.size());
+    for (auto& x : batchReads) {
+        keys.emplace_back(x.key);
+    }
+
+    ++this->batches;
+    uint64_t size = keys.size();
+    uint64_t current = this->maxBatchSeen.load();
+    while (size > current && !this->maxBatchSeen.compare_exchange_weak(current, size)) {}
+
+    std::vector<std::string> values;
+    try {
+        values = this->fetch(keys);
+    }
+    catch (std::exception& e) {
+        values.clear();
+    }
+
+    // a failed or short fetch must not be taken for "not found"
+    if (values.size() != batchReads.size()) {
+        for (auto& x : batchReads) {
+            x.done(std::string(), true);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < batchReads.size(); ++i) {
+        batchReads[i].done(std::move(values[i]), false);
+    }
+}
+
+DBReadBatcher::Stats DBReadBatcher::getStats() const {
+    return Stats{
+        this->batches.load(),
+        this->reads.load(),
+        this->maxBatchSeen.load()
+    };
+}
@@ -3,25 +3,147 @@
 #include <epochserver/epochserver.hpp>
 using namespace std::literals::string_literals;
 
+thread_local std::optional<Executor::Priority> DBWorker::priorityOverride;
+
 DBWorker::DBWorker(const DBConfig& dbConfig) {
     this->dbConfig = dbConfig;
     this->isSqlDB = dbConfig.dbType == DBType::MY_SQL;
 
-    // Threadpool threads + current
-    this->dbConnectorsCount = threadpool->getPoolSize() + 1;
-    this->dbConnectors.reserve(this->dbConnectorsCount);
-    for (size_t i = 0; i < this->dbConnectorsCount; ++i) {
-        this->dbConnectors.emplace_back(
-            std::pair < std::thread::id, DBConRef >(
-                std::thread::id(), nullptr
-            )
-        );
+    size_t threads = dbConfig.executorThreads > 0 ? dbConfig.executorThreads : threadpool->getPoolSize();
+    this->executor = std::make_unique<Executor>(dbConfig.connectionName, threads, dbConfig.executorQueueMax, std::chrono::milliseconds(dbConfig.executorAgingMs));
+
+    this->asyncConnector = dbConfig.dbType == DBType::REDIS && dbConfig.redisAsync;
+
+    // by default every executor thread + the game thread (SYNC calls) can hold a connection,
+    // pipelined redis connections are shared by all of them and two are enough
+    size_t defaultMax = dbConfig.dbType == DBType::REDIS && dbConfig.redisPipeline ? 2 : threads + 1;
+    size_t maxSize = dbConfig.poolMax > 0 ? dbConfig.poolMax : defaultMax;
+    // async calls are only ordered by the connection they are sent on, a key must not be spread over several
+    if (this->asyncConnector) {
+        if (maxSize > 1) {
+            WARNING("Async calls of " + dbConfig.connectionName + " share one connection, pool max " + std::to_string(maxSize) + " is ignored");
+        }
+        maxSize = 1;
     }
+    // by default all of them are opened at startup, so the first calls do not pay for the connect
+    size_t minSize = dbConfig.poolMin > 0 ? dbConfig.poolMin : maxSize;
+    this->connections = std::make_unique<DBConnectionPool>(
+        dbConfig,
+        *this->executor,
+        minSize,
+        maxSize,
+        std::chrono::seconds(dbConfig.poolIdleTimeout),
+        std::chrono::milliseconds(dbConfig.poolCheckoutTimeoutMs)
+    );
 
-    this->getConnector();
+    if (this->asyncConnector) {
+        auto lease = this->connections->checkout();
+        if (!lease->supportsAsync()) {
+            throw std::runtime_error("Connector of " + dbConfig.connectionName + " does not support async calls");
+        }
+    }
+
+    // async gets are pipelined by the connector already
+    if (dbConfig.readBatchMax > 1 && !this->asyncConnector) {
+        this->readBatcher = std::make_unique<DBReadBatcher>(
+            *this->executor,
+            [this](const std::vector<std::string>& keys) {
+                auto result = this->__runOnConnection([&keys](const DBConRef& ref) {
+                    return DBReturn(ref->getMany(keys));
+                });
+                return std::move(std::get<std::vector<std::string>>(result));
+            },
+            std::chrono::microseconds(dbConfig.readBatchWindowUs),
+            dbConfig.readBatchMax
+        );
+    }
 }
 
 DBWorker::~DBWorker() {
+    // in this order before the other members are gone, closing the connections completes
+    // the async calls still in flight and their completions use the cache
+    this->executor.reset();
+    this->readBatcher.reset();
+    this->connections.reset();
+}
+
+void DBWorker::formatResult(const DBReturn& result, std::string& out) {
+    switch (result.index()) {
+        // string
+        case 0: {
+            auto& str = std::get<std::string>(result);
+            out.reserve(out.size() + str.size() + 2);
+            out += "\"";
+            out += str;
+            out += "\"";
+            break;
+        }
+        //bool
+        case 1: {
+            out += std::to_string(std::get<bool>(result));
+            break;
+        }
+        //int
+        case 2: {
+            out += std::to_string(std::get<int>(result));
+            break;
+        }
+        // string,int
+        case 3: {
+            auto& pair = std::get<std::pair<std::string, int>>(result);
+            out.reserve(out.size() + pair.first.size() + 16);
+            out += "[\"";
+            out += pair.first;
+            out += "\",";
+            out += std::to_string(pair.second);
+            out += "]";
+            break;
+        }
+        // vector string
+        case 4: {
+            auto& vec = std::get< std::vector<std::string> >(result);
+            out += "[";
+            for (size_t i = 0; i < vec.size(); ++i) {
+                if (i > 0) {
+                    out += ",";
+                }
+                out += "\"";
+                out += vec[i];
+                out += "\"";
+            }
+            out += "]";
+            break;
+        }
+        // next cursor, keys
+        case 5: {
+            auto& page = std::get<DBKeyPage>(result);
+            out += "[\"";
+            out += page.first;
+            out += "\",[";
+            for (size_t i = 0; i < page.second.size(); ++i) {
+                if (i > 0) {
+                    out += ",";
+                }
+                out += "\"";
+                out += page.second[i];
+                out += "\"";
+            }
+            out += "]]";
+            break;
+        }
+    };
+}
+
+DBTicket DBWorker::reserveTicket() {
+    return server->reserveTicket();
+}
+
+void DBWorker::fulfillTicket(DBTicket ticket, const DBReturn& result) {
+    server->insertTicketResult(ticket, result);
+}
+
+void DBWorker::cancelTicket(DBTicket ticket) {
+    server->cancelTicket(ticket);
 }
 
 void DBWorker::callbackResultIfNeeded(
@@ -46,40 +168,7 @@ void DBWorker::callbackResultIfNeeded(
         }
         cbh.functionIsCode = !cbh.function.empty() && cbh.function[0] == '{';
         
-        std::stringstream buffer;
-        switch (result.index()) {
-            // string
-            case 0: {
-                buffer << "\"" << std::get<std::string>(result) << "\"";
-                break;
-            }
-            //bool
-            case 1: {
-                buffer << std::to_string(std::get<bool>(result));
-                break;
-            }
-            //int
-            case 2: {
-                buffer << std::to_string(std::get<int>(result));
-                break;
-            }
-            // string,int
-            case 3: {
-                buffer << "[\"" << std::get<std::pair<std::string,int>>(result).first << "\"," << std::to_string(std::get<std::pair<std::string,int>>(result).second) << "]";
-                break;
-            }
-            // vector string
-            case 4: {
-                auto& vec = std::get< std::vector<std::string> >(result);
-                buffer << "[";
-                for (size_t i = 0; i < vec.size(); ++i) {
-                    buffer << "\"" << vec[i] << "\"" << ((i == (vec.size() - 1)) ? "" : ",");
-                }
-                buffer << "]";
-                break;
-            }
-        };
-        cbh.result = buffer.str();
+        formatResult(result, cbh.result);
 
         server->insertCallback(cbh);
     }
@@ -108,48 +197,191 @@ void DBWorker::callbackResultIfNeeded(
 
 }
 
-DBConRef DBWorker::getConnector() {
-    auto tid = std::this_thread::get_id();
-    for (auto& x : this->dbConnectors) {
-        if (x.first == tid) {
-            return x.second;
-        }
+DBEntryPage DBWorker::scanEntries(const std::string& prefix, const std::string& cursor, size_t count) {
+    auto lease = this->connections->checkout();
+    try {
+        return lease->scanEntries(prefix, cursor, count);
     }
-    auto newID = this->dbConnectorUID++;
-    if (newID >= this->dbConnectorsCount) {
-        throw std::runtime_error("Unexpected amout of threads tried to get database connectors");
+    catch (...) {
+        lease.markSuspect();
+        throw;
     }
-    DBConRef connector;
-    try {
-        switch (dbConfig.dbType) {
-            case DBType::MY_SQL: {
-                connector = std::make_shared<MySQLConnector>(this->dbConfig);
-                break;
-            }
-            case DBType::SQLITE: {
-                connector = std::make_shared<SQLiteConnector>(this->dbConfig);
-                break;
-            }
-            case DBType::REDIS: {
-                connector = std::make_shared<RedisConnector>(this->dbConfig);
-                break;
+}
+
+void DBWorker::__beginWrites(const std::vector<std::string>& keys, Executor::Priority lane) {
+    std::lock_guard<std::mutex> lock(this->keyWritesMutex);
+    for (auto& key : keys) {
+        auto& writes = this->keyWrites[key];
+        if (!writes) {
+            writes = std::make_shared<KeyWrites>();
+        }
+        ++writes->issued;
+        writes->lane = std::max(writes->lane, lane);
+    }
+}
+
+void DBWorker::__endWrites(const std::vector<std::string>& keys) {
+    {
+        std::lock_guard<std::mutex> lock(this->keyWritesMutex);
+        for (auto& key : keys) {
+            auto it = this->keyWrites.find(key);
+            if (it == this->keyWrites.end()) continue;
+
+            // waiting reads hold on to the entry, a new write of the key starts a new one
+            if (++it->second->done == it->second->issued) {
+                this->keyWrites.erase(it);
             }
-            default: {
-                WARNING("Unknown Database type");
-                break;
+        }
+    }
+    this->keyWritesCv.notify_all();
+}
+
+bool DBWorker::__hasPendingWrites(const std::string& key) {
+    std::lock_guard<std::mutex> lock(this->keyWritesMutex);
+    return this->keyWrites.find(key) != this->keyWrites.end();
+}
+
+DBWorker::ReadStart DBWorker::__beginRead(const std::string& key, Executor::Priority& priority) {
+    ReadStart read{ this->__readToken(key), nullptr, 0 };
+
+    std::lock_guard<std::mutex> lock(this->keyWritesMutex);
+    auto it = this->keyWrites.find(key);
+    if (it != this->keyWrites.end()) {
+        read.writes = it->second;
+        read.after = it->second->issued;
+        priority = std::max(priority, it->second->lane);
+    }
+    return read;
+}
+
+void DBWorker::__awaitWrites(const ReadStart& read) {
+    if (!read.writes) return;
+
+    // a single executor thread took the writes before this read (FIFO lane), waiting could only block a write that is not queued yet
+    if (this->executor->getThreadCount() == 1 && this->executor->isCurrent()) return;
+
+    std::unique_lock<std::mutex> lock(this->keyWritesMutex);
+    this->keyWritesCv.wait(lock, [&read]() { return read.writes->done >= read.after; });
+}
+
+void DBWorker::__batchGet(std::string&& key, std::function<void(const DBReturn& result, bool failed)>&& done) {
+    uint64_t token = this->__readToken(key);
+    std::string batchKey = key;
+    this->readBatcher->add(
+        std::move(batchKey),
+        [this, key = std::move(key), token, done = std::move(done)](std::string&& value, bool failed) {
+            if (!failed && value.empty()) {
+                this->__onNotFound(key, token);
             }
-        };
+            done(DBReturn(std::move(value)), failed);
+        },
+        __callPriority(Executor::Priority::HIGH)
+    );
+}
+
+DBReturn DBWorker::__runOnConnection(const std::function<DBReturn(const DBConRef& ref)>& fnc) {
+    auto lease = this->connections->checkout();
+    try {
+        return fnc(lease.get());
     }
-    catch (const std::runtime_error& e) {
-        WARNING("Runtime Error during connector creation: "s + e.what());
-        throw std::runtime_error("Could not create database connector");
+    catch (...) {
+        lease.markSuspect();
+        throw;
     }
-    if (!connector) {
-        WARNING("Database connector could not be created");
-        throw std::runtime_error("Database connector could not be created");
+}
+
+void DBWorker::__runAsync(const std::function<void(const DBConRef& ref, AsyncDone&& done)>& fnc, AsyncDone&& done) {
+    uint64_t inFlight = ++this->asyncInFlight;
+    if (this->dbConfig.redisAsyncMaxInFlight > 0 && inFlight > this->dbConfig.redisAsyncMaxInFlight) {
+        --this->asyncInFlight;
+        ++this->asyncRejected;
+        throw std::runtime_error("Too many calls in flight on " + this->dbConfig.connectionName + " (" + std::to_string(this->dbConfig.redisAsyncMaxInFlight) + ")");
     }
+    ++this->asyncCalls;
+    __recordMax(this->asyncMaxInFlight, inFlight);
+
+    // the connector may fail after it took the completion and the reply may come after the timeout,
+    // the flag makes sure it only runs once
+    auto completion = std::make_shared<AsyncDone>(std::move(done));
+    auto called = std::make_shared<std::atomic<bool>>(false);
+    auto start = utils::sysclock::now();
+    bool tracked = this->dbConfig.redisReplyTimeoutMs > 0;
+    uint64_t id = 0;
+    if (tracked) {
+        std::lock_guard<std::mutex> lock(this->asyncMutex);
+        id = ++this->asyncNextId;
+    }
+    AsyncDone once = [this, completion, called, start, tracked, id](DBReturn&& result, bool failed) {
+        if (called->exchange(true)) return;
+
+        if (tracked) {
+            std::lock_guard<std::mutex> lock(this->asyncMutex);
+            this->asyncPending.erase(id);
+        }
+
+        uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(utils::sysclock::now() - start).count());
+        this->asyncMicros += micros;
+        __recordMax(this->asyncMaxMicros, micros);
+        if (failed) {
+            ++this->asyncFailed;
+        }
+        ++this->asyncCompleted;
+        --this->asyncInFlight;
+
+        (*completion)(std::move(result), failed);
+    };
+    if (tracked) {
+        std::lock_guard<std::mutex> lock(this->asyncMutex);
+        this->asyncPending.emplace(id, PendingAsync{ start + std::chrono::milliseconds(this->dbConfig.redisReplyTimeoutMs), once });
+    }
+
+    try {
+        // shared connections, the checkout neither waits for another call nor connects
+        auto lease = this->connections->tryCheckout();
+        try {
+            fnc(lease.get(), AsyncDone(once));
+        }
+        catch (...) {
+            lease.markSuspect();
+            throw;
+        }
+    }
+    catch (std::exception& e) {
+        once(DBReturn(), true);
+    }
+}
+
+size_t DBWorker::expireAsyncCalls() {
+    std::vector<AsyncDone> overdue;
+    {
+        auto now = utils::sysclock::now();
+        std::lock_guard<std::mutex> lock(this->asyncMutex);
+        auto it = this->asyncPending.begin();
+        while (it != this->asyncPending.end() && it->second.deadline <= now) {
+            overdue.emplace_back(std::move(it->second.done));
+            it = this->asyncPending.erase(it);
+        }
+    }
+    if (overdue.empty()) return 0;
+
+    WARNING(std::to_string(overdue.size()) + " calls on " + this->dbConfig.connectionName + " got no reply within " + std::to_string(this->dbConfig.redisReplyTimeoutMs) + "ms");
+    this->asyncTimedOut += overdue.size();
+    for (auto& x : overdue) {
+        x(DBReturn(), true);
+    }
+    return overdue.size();
+}
 
-    this->dbConnectors[newID].second = connector;
-    this->dbConnectors[newID].first = tid;
-    return connector;
+DBWorker::AsyncStats DBWorker::getAsyncStats() const {
+    return AsyncStats{
+        this->asyncCalls.load(),
+        this->asyncCompleted.load(),
+        this->asyncFailed.load(),
+        this->asyncRejected.load(),
+        this->asyncInFlight.load(),
+        this->asyncMaxInFlight.load(),
+        this->asyncMicros.load(),
+        this->asyncMaxMicros.load(),
+        this->asyncTimedOut.load()
+    };
 }
@@ -0,0 +1,244 @@
+#include <database/DBWriteBuffer.hpp>
+
+DBWriteBuffer::DBWriteBuffer(const std::shared_ptr<DBWorker>& worker, std::chrono::milliseconds window, size_t maxBytes)
+    : worker(worker), window(window), maxBytes(maxBytes) {
+    this->flusher = std::thread(&DBWriteBuffer::__run, this);
+}
+
+DBWriteBuffer::~DBWriteBuffer() {
+    this->__stopFlusher();
+}
+
+void DBWriteBuffer::__stopFlusher() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->cv.notify_all();
+    if (this->flusher.joinable()) {
+        this->flusher.join();
+    }
+}
+
+DBWriteBuffer::BatchRef DBWriteBuffer::__take() {
+    auto batch = std::make_shared<Batch>();
+    batch->swap(this->pending);
+    this->pendingBytes = 0;
+
+    // the new values win, older queued values of the keys are never written
+    for (auto& older : this->queued) {
+        for (auto& x : *batch) {
+            this->absorbed += older->erase(x.first);
+        }
+    }
+    this->queued.push_back(batch);
+    return batch;
+}
+
+bool DBWriteBuffer::__extract(const std::string& key, PendingWrite& out) {
+    bool found = false;
+
+    auto it = this->pending.find(key);
+    if (it != this->pending.end()) {
+        this->pendingBytes -= it->first.size() + it->second.value.size();
+        out = std::move(it->second);
+        this->pending.erase(it);
+        found = true;
+    }
+    for (auto batch = this->queued.rbegin(); batch != this->queued.rend(); ++batch) {
+        auto queuedIt = (*batch)->find(key);
+        if (queuedIt == (*batch)->end()) continue;
+
+        if (found) {
+            ++this->absorbed;
+        }
+        else {
+            out = std::move(queuedIt->second);
+            found = true;
+        }
+        (*batch)->erase(queuedIt);
+    }
+    return found;
+}
+
+void DBWriteBuffer::__waitWritten(std::unique_lock<std::mutex>& lock, const std::string& key) {
+    this->writtenCv.wait(lock, [this, &key]() {
+        return this->writing.find(key) == this->writing.end();
+    });
+}
+
+void DBWriteBuffer::__writeBatch(const BatchRef& batch) {
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        // keys can still be taken out of the batch while it waits (drop, flushKey, newer batches)
+        this->writtenCv.wait(lock, [this, &batch]() {
+            for (auto& x : *batch) {
+                if (this->writing.find(x.first) != this->writing.end()) return false;
+            }
+            return true;
+        });
+        this->queued.remove(batch);
+        for (auto& x : *batch) {
+            this->writing.insert(x.first);
+        }
+    }
+    try {
+        this->__write(*batch);
+    }
+    catch (...) {
+        this->__finish(*batch);
+        throw;
+    }
+    this->__finish(*batch);
+}
+
+void DBWriteBuffer::__write(Batch& batch) {
+    if (batch.empty()) return;
+
+    // always setExMany, a key ends up the same no matter how many others are flushed with it (ttl -1 does not expire)
+    std::vector<DBKeyEntry> entries;
+    entries.reserve(batch.size());
+    for (auto& x : batch) {
+        entries.emplace_back(x.first, std::pair<std::string, int>(std::move(x.second.value), x.second.ttl));
+    }
+    // the SYNC call reports errors (including exceptions) as false
+    DBReturn result = this->worker->setExMany<DBExecutionType::SYNC>(std::move(entries));
+    if (std::holds_alternative<bool>(result) && std::get<bool>(result)) {
+        this->issued += batch.size();
+        return;
+    }
+
+    this->failed += batch.size();
+    WARNING("Write-behind of " + std::to_string(batch.size()) + " keys failed, their cached values are dropped");
+    // the cache must not keep serving values that never reached the database
+    if (auto& cache = this->worker->getCache()) {
+        for (auto& x : batch) {
+            cache->invalidate(x.first);
+        }
+    }
+}
+
+void DBWriteBuffer::__finish(const Batch& batch) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto& x : batch) {
+            this->writing.erase(x.first);
+        }
+    }
+    this->writtenCv.notify_all();
+}
+
+void DBWriteBuffer::__run() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->stop) {
+        this->cv.wait_for(lock, this->window);
+        if (this->pending.empty()) continue;
+
+        auto batch = this->__take();
+        lock.unlock();
+        try {
+            this->worker->getExecutor().fireAndForget([this, batch]() {
+                this->__writeBatch(batch);
+            }, Executor::Priority::LOW);
+        }
+        catch (std::exception& e) {
+            // the executor is backed up, writing here holds back the next flush instead of dropping the batch
+            this->__writeBatch(batch);
+        }
+        lock.lock();
+    }
+}
+
+bool DBWriteBuffer::write(const std::string& key, const std::string& value, int ttl) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    if (this->stop) {
+        ++this->rejected;
+        return false;
+    }
+
+    auto it = this->pending.find(key);
+    size_t freed = it != this->pending.end() ? it->second.value.size() : 0;
+    size_t added = it != this->pending.end() ? value.size() : key.size() + value.size();
+
+    if (this->pendingBytes - freed + added > this->maxBytes) {
+        // let the flusher start early, this write goes directly
+        lock.unlock();
+        this->cv.notify_one();
+        ++this->rejected;
+        return false;
+    }
+
+    if (it != this->pending.end()) {
+        it->second.value = value;
+        it->second.ttl = ttl;
+        ++this->absorbed;
+    }
+    else {
+        this->pending.emplace(key, PendingWrite{ value, ttl });
+    }
+    this->pendingBytes = this->pendingBytes - freed + added;
+    ++this->buffered;
+    return true;
+}
+
+void DBWriteBuffer::drop(const std::string& key) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    // a write that already started lands before the direct call, everything newer is superseded by it
+    this->__waitWritten(lock, key);
+
+    PendingWrite dropped;
+    if (this->__extract(key, dropped)) {
+        ++this->absorbed;
+    }
+}
+
+void DBWriteBuffer::flushKey(const std::string& key) {
+    Batch batch;
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        this->__waitWritten(lock, key);
+
+        PendingWrite write;
+        if (!this->__extract(key, write)) return;
+
+        batch.emplace(key, std::move(write));
+        this->writing.insert(key);
+    }
+    try {
+        // on the calling thread, the read or expire that needs this write is issued right after it returns
+        this->__write(batch);
+    }
+    catch (...) {
+        this->__finish(batch);
+        throw;
+    }
+    this->__finish(batch);
+}
+
+void DBWriteBuffer::close() {
+    this->__stopFlusher();
+
+    BatchRef batch;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->pending.empty()) return;
+        batch = this->__take();
+    }
+
+    // written on the calling thread, the executor may be backed up on shutdown
+    this->__writeBatch(batch);
+}
+
+DBWriteBuffer::Stats DBWriteBuffer::getStats() const {
+    return Stats{
+        this->buffered.load(),
+        this->absorbed.load(),
+        this->issued.load(),
+        this->failed.load(),
+        this->rejected.load()
+    };
+}
@@ -2,14 +2,43 @@
 
 #include <sstream>
 #include <ctime>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+
+namespace MySQLConnector_Detail {
+    // mysql_library_init() is not called by mariadbpp, without it creating connections from several threads is not threadsafe
+    std::once_flag libraryInit;
+
+    // errors after which the session or its prepared statements are gone
+    bool isSessionLost(uint32_t errorNo) {
+        return errorNo == 2006     // CR_SERVER_GONE_ERROR
+            || errorNo == 2013     // CR_SERVER_LOST
+            || errorNo == 2055     // CR_SERVER_LOST_EXTENDED
+            || errorNo == 1243;    // ER_UNKNOWN_STMT_HANDLER
+    }
+
+    // LIKE pattern that matches the prefix literally
+    std::string likePrefix(const std::string& prefix) {
+        std::string ret;
+        ret.reserve(prefix.size() + 2);
+        for (char c : prefix) {
+            if (c == '%' || c == '_' || c == '\\') {
+                ret += '\\';
+            }
+            ret += c;
+        }
+        ret += '%';
+        return ret;
+    }
+};
 
 MySQLConnector::MySQLConnector(const DBConfig& config) {
     this->config = config;
 
-    if (MySQLConnector_Detail::is_first_connection) {
-        MySQLConnector_Detail::is_first_connection = false;
+    std::call_once(MySQLConnector_Detail::libraryInit, []() {
         mysql_library_init(0, NULL, NULL);
-    }
+    });
 
     //CONNECT
     mariadb::account_ref acc = mariadb::account::create(
@@ -42,6 +71,8 @@ MySQLConnector::MySQLConnector(const DBConfig& config) {
         throw std::runtime_error("Could not connect to the database server");
     }
 
+    this->__initStatementTexts();
+
     // throws before if not connected
     INFO("Database selected! Checking table...");
     if (this->__createKeyValueTable(this->defaultKeyValTableName)) {
@@ -56,6 +87,162 @@ MySQLConnector::MySQLConnector(const DBConfig& config) {
 
 MySQLConnector::~MySQLConnector() {}
 
+void MySQLConnector::__initStatementTexts() {
+    // the table name can not be a parameter
+    const std::string table = "`" + this->defaultKeyValTableName + "`";
+    const std::string alive = " AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
+    const std::string remaining = "UNIX_TIMESTAMP(`ttl`) - UNIX_TIMESTAMP(CURRENT_TIMESTAMP())";
+
+    auto text = [this](Statement which) -> std::string& { return this->statementTexts[static_cast<size_t>(which)]; };
+
+    text(Statement::GET) = "SELECT `value` FROM " + table + " WHERE `key`=?" + alive;
+    text(Statement::GET_WITH_TTL) = "SELECT `value`, " + remaining + " FROM " + table + " WHERE `key`=?" + alive;
+    text(Statement::EXISTS) = "SELECT 1 FROM " + table + " WHERE `key`=?" + alive;
+    text(Statement::TTL) = "SELECT " + remaining + " FROM " + table + " WHERE `key`=?" + alive;
+    text(Statement::SET) = this->__bulkInsertText(1, false);
+    text(Statement::SET_EX) = this->__bulkInsertText(1, true);
+    text(Statement::EXPIRE) = "UPDATE " + table + " SET `ttl`=DATE_ADD(NOW(),INTERVAL ? SECOND) WHERE `key`=?";
+    text(Statement::DEL) = "DELETE FROM " + table + " WHERE `key`=?";
+    text(Statement::KEYS) = "SELECT `key` FROM " + table + " WHERE `key` LIKE ?" + alive;
+    text(Statement::SCAN_FIRST) = "SELECT `key` FROM " + table + " WHERE `key` LIKE ?" + alive + " ORDER BY `key` LIMIT ?";
+    text(Statement::SCAN_NEXT) = "SELECT `key` FROM " + table + " WHERE `key` LIKE ? AND `key` > ?" + alive + " ORDER BY `key` LIMIT ?";
+    text(Statement::SCAN_ENTRIES_FIRST) = "SELECT `key`, `value`, " + remaining + " FROM " + table + " WHERE `key` LIKE ?" + alive + " ORDER BY `key` LIMIT ?";
+    text(Statement::SCAN_ENTRIES_NEXT) = "SELECT `key`, `value`, " + remaining + " FROM " + table + " WHERE `key` LIKE ? AND `key` > ?" + alive + " ORDER BY `key` LIMIT ?";
+    text(Statement::SET_MANY) = this->__bulkInsertText(bulkRows, false);
+    text(Statement::SET_EX_MANY) = this->__bulkInsertText(bulkRows, true);
+}
+
+std::string MySQLConnector::__bulkInsertText(size_t rows, bool withTtl) const {
+    const std::string row = withTtl ? "(?,?,DATE_ADD(NOW(),INTERVAL ? SECOND))" : "(?,?)";
+
+    std::string ret = "INSERT INTO `" + this->defaultKeyValTableName + "` (`key`,`value`" + (withTtl ? ",`ttl`" : "") + ") VALUES ";
+    ret.reserve(ret.size() + rows * (row.size() + 1) + 64);
+    for (size_t i = 0; i < rows; ++i) {
+        if (i > 0) ret += ',';
+        ret += row;
+    }
+    ret += " ON DUPLICATE KEY UPDATE value = VALUES(value)";
+    // like SETEX / SET in redis: a set without ttl makes an expiring key persistent
+    ret += withTtl ? ", ttl = VALUES(ttl)" : ", ttl = NULL";
+    return ret;
+}
+
+mariadb::statement_ref& MySQLConnector::__prepared(Statement which) {
+    auto& statement = this->statements[static_cast<size_t>(which)];
+    if (!statement) {
+        auto prepared = this->con->create_statement(this->statementTexts[static_cast<size_t>(which)]);
+        if (!prepared || prepared->error_no() != 0) {
+            throw std::runtime_error("Preparing a statement failed: " + (prepared ? prepared->error() : this->con->error()));
+        }
+        statement = std::move(prepared);
+    }
+    return statement;
+}
+
+void MySQLConnector::__reconnect() {
+    // prepared statements belong to the old session
+    for (auto& x : this->statements) {
+        x.reset();
+    }
+
+    this->con->disconnect();
+    if (!this->con->connect() || !this->con->set_schema(this->config.dbname)) {
+        throw std::runtime_error("Could not reconnect to the database server");
+    }
+}
+
+template<typename F>
+auto MySQLConnector::__run(Statement which, F&& fnc) {
+    // a lost session is reconnected once, the statements are prepared again on the new one
+    for (int attempt = 0; ; ++attempt) {
+        mariadb::statement_ref statement;
+        try {
+            statement = this->__prepared(which);
+            auto ret = fnc(statement);
+            if (attempt > 0 || !MySQLConnector_Detail::isSessionLost(statement->error_no())) {
+                return ret;
+            }
+        }
+        catch (std::exception& e) {
+            bool lost = (statement && MySQLConnector_Detail::isSessionLost(statement->error_no())) || !this->con->connected();
+            if (attempt > 0 || !lost) {
+                throw;
+            }
+        }
+
+        INFO("Connection to " + this->config.connectionName + " lost, reconnecting and preparing the statements again");
+        this->__reconnect();
+    }
+}
+
+template<typename E, typename B>
+bool MySQLConnector::__writeMany(const std::vector<E>& entries, bool withTtl, B&& bind) {
+    if (entries.empty()) return true;
+
+    for (int attempt = 0; ; ++attempt) {
+        bool lost = false;
+        try {
+            // uncommitted chunks are rolled back when the transaction goes out of scope, one statement needs none
+            mariadb::transaction_ref transaction;
+            if (entries.size() > bulkRows) {
+                transaction = this->con->create_transaction();
+                if (!transaction) {
+                    throw std::runtime_error("Starting a transaction failed: " + this->con->error());
+                }
+            }
+
+            for (size_t offset = 0; offset < entries.size(); offset += bulkRows) {
+                size_t rows = std::min(bulkRows, entries.size() - offset);
+
+                mariadb::statement_ref statement;
+                if (rows == bulkRows) {
+                    statement = this->__prepared(withTtl ? Statement::SET_EX_MANY : Statement::SET_MANY);
+                }
+                else if (rows == 1) {
+                    statement = this->__prepared(withTtl ? Statement::SET_EX : Statement::SET);
+                }
+                else {
+                    statement = this->con->create_statement(this->__bulkInsertText(rows, withTtl));
+                    if (!statement || statement->error_no() != 0) {
+                        lost = statement && MySQLConnector_Detail::isSessionLost(statement->error_no());
+                        throw std::runtime_error("Preparing a statement failed: " + (statement ? statement->error() : this->con->error()));
+                    }
+                }
+
+                uint32_t param = 0;
+                for (size_t i = offset; i < offset + rows; ++i) {
+                    bind(statement, param, entries[i]);
+                }
+
+                // an unchanged value affects no rows, only errors count
+                statement->execute();
+                if (statement->error_no() != 0) {
+                    if (!MySQLConnector_Detail::isSessionLost(statement->error_no())) {
+                        WARNING("Bulk write of " + std::to_string(entries.size()) + " entries failed: " + statement->error());
+                        return false;
+                    }
+                    lost = true;
+                    throw std::runtime_error("Connection lost during a bulk write: " + statement->error());
+                }
+            }
+
+            if (transaction) {
+                transaction->commit();
+            }
+            return true;
+        }
+        catch (std::exception& e) {
+            lost = lost || !this->con->connected();
+            if (attempt > 0 || !lost) {
+                throw;
+            }
+        }
+
+        INFO("Connection to " + this->config.connectionName + " lost, reconnecting and writing the batch again");
+        this->__reconnect();
+    }
+}
+
 bool MySQLConnector::__createKeyValueTable(const std::string& tableName) {
 
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
@@ -104,47 +291,73 @@ std::vector<std::string> MySQLConnector::keys(const std::string & prefix)
 {
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "SELECT `key` FROM ? WHERE `key` LIKE ? AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
-
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, prefix + "%");
-
-    auto res = statement->query();
-    if (!res || res->error_no() != 0 || res->row_count() == 0) {
-        if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
-        return {};
-    }
-    else {
+    return this->__run(Statement::KEYS, [this, &prefix](mariadb::statement_ref& statement) {
+        statement->set_string(0, MySQLConnector_Detail::likePrefix(prefix));
 
         std::vector<std::string> ret;
+        auto res = statement->query();
+        if (!res || res->error_no() != 0 || res->row_count() == 0) {
+            if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
+            return ret;
+        }
+
         ret.reserve(res->row_count());
-        do {
+        while (res->next()) {
             ret.emplace_back(res->get_string(0));
-        } while (res->next());
+        }
+        return ret;
+    });
+}
+
+DBKeyPage MySQLConnector::scanKeys(const std::string& prefix, const std::string& cursor, size_t count) {
 
+    if (!this->con) throw std::runtime_error("Mysql DB undefined");
+    count = std::min<size_t>(std::max<size_t>(count, 1), UINT32_MAX - 1);
+
+    // keyset pagination: the cursor is the last key of the previous page, the primary key index is read from there on.
+    // One row more than asked tells whether there is a next page
+    return this->__run(cursor.empty() ? Statement::SCAN_FIRST : Statement::SCAN_NEXT, [this, &prefix, &cursor, count](mariadb::statement_ref& statement) {
+        uint32_t param = 0;
+        statement->set_string(param++, MySQLConnector_Detail::likePrefix(prefix));
+        if (!cursor.empty()) {
+            statement->set_string(param++, cursor);
+        }
+        statement->set_unsigned32(param, static_cast<uint32_t>(count + 1));
+
+        DBKeyPage ret;
+
+        auto res = statement->query();
+        if (!res || res->error_no() != 0) {
+            // an empty page with cursor "" would end the listing as if it was complete
+            throw std::runtime_error("Key listing failed: " + (res ? res->error() : "empty result"));
+        }
+
+        ret.second.reserve(std::min<size_t>(res->row_count(), count + 1));
+        while (res->next()) {
+            ret.second.emplace_back(res->get_string(0));
+        }
+        if (ret.second.size() > count) {
+            ret.second.pop_back();
+            ret.first = ret.second.back();
+        }
         return ret;
-    }
+    });
 }
 
 std::string MySQLConnector::get(const std::string& _key) {
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
-    
-    std::string execQry = "SELECT `value` FROM ? WHERE `key`=? AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
 
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, _key);
+    return this->__run(Statement::GET, [this, &_key](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
 
-    auto res = statement->query();
-    if (!res || res->error_no() != 0 || res->row_count() == 0) {
-        if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
-        return "";
-    }
-    else {
+        auto res = statement->query();
+        if (!res || res->error_no() != 0 || !res->next()) {
+            if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
+            return std::string();
+        }
         return res->get_string(0);
-    }
+    });
 }
 
 std::string MySQLConnector::getRange(const std::string& key, unsigned int from, unsigned int to) {
@@ -167,98 +380,185 @@ std::pair<std::string, int> MySQLConnector::getWithTtl(const std::string& _key)
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "SELECT `value`, UNIX_TIMESTAMP(`ttl`), UNIX_TIMESTAMP(CURRENT_TIMESTAMP()) FROM ? WHERE `key`=? AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
+    return this->__run(Statement::GET_WITH_TTL, [this, &_key](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
+
+        auto res = statement->query();
+        if (!res || res->error_no() != 0 || !res->next()) {
+            if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
+            return std::pair<std::string, int>("", -1);
+        }
+        // no ttl -> -1 like redis
+        return std::pair<std::string, int>(res->get_string(0), res->get_is_null(1) ? -1 : static_cast<int>(res->get_signed64(1)));
+    });
+}
+
+DBEntryPage MySQLConnector::scanEntries(const std::string& prefix, const std::string& cursor, size_t count) {
+
+    if (!this->con) throw std::runtime_error("Mysql DB undefined");
+    count = std::min<size_t>(std::max<size_t>(count, 1), UINT32_MAX - 1);
+
+    // keyset pagination like scanKeys, one round trip per page instead of one query per key
+    return this->__run(cursor.empty() ? Statement::SCAN_ENTRIES_FIRST : Statement::SCAN_ENTRIES_NEXT, [&prefix, &cursor, count](mariadb::statement_ref& statement) {
+        uint32_t param = 0;
+        statement->set_string(param++, MySQLConnector_Detail::likePrefix(prefix));
+        if (!cursor.empty()) {
+            statement->set_string(param++, cursor);
+        }
+        statement->set_unsigned32(param, static_cast<uint32_t>(count + 1));
+
+        auto res = statement->query();
+        if (!res || res->error_no() != 0) {
+            // a partial load would be taken for the whole keyspace
+            throw std::runtime_error("Bulk load failed: " + (res ? res->error() : "empty result"));
+        }
+
+        DBEntryPage ret;
+        ret.second.reserve(std::min<size_t>(res->row_count(), count + 1));
+        while (res->next()) {
+            ret.second.emplace_back(
+                res->get_string(0),
+                std::pair<std::string, int>(res->get_string(1), res->get_is_null(2) ? -1 : static_cast<int>(res->get_signed64(2)))
+            );
+        }
+        if (ret.second.size() > count) {
+            ret.second.pop_back();
+            ret.first = ret.second.back().first;
+        }
+        return ret;
+    });
+}
+
+std::vector<std::string> MySQLConnector::getMany(const std::vector<std::string>& keys) {
+
+    if (!this->con) throw std::runtime_error("Mysql DB undefined");
+    if (keys.empty()) return {};
+
+    // one query for the whole batch, rows come back in any order
+    std::string execQry = "SELECT `key`, `value` FROM `" + this->defaultKeyValTableName + "` WHERE `key` IN (";
+    execQry.reserve(execQry.size() + keys.size() * 2 + 64);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        execQry += i > 0 ? ",?" : "?";
+    }
+    execQry += ") AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
 
     auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, _key);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        statement->set_string(static_cast<uint32_t>(i), keys[i]);
+    }
+
+    std::vector<std::string> ret(keys.size());
+
     auto res = statement->query();
-    if (!res || res->error_no() != 0 || res->row_count() == 0) {
-        if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
-        return { "", 0 };
+    if (!res || res->error_no() != 0) {
+        // "" would read as "not found" for every key of the batch
+        throw std::runtime_error("Multi get failed: " + (res ? res->error() : "empty result"));
     }
-    else {
-        return { res->get_string(0), res->get_signed64(1) - res->get_signed64(2) };
+
+    std::unordered_map<std::string, std::string> found;
+    found.reserve(res->row_count());
+    while (res->next()) {
+        found.emplace(res->get_string(0), res->get_string(1));
     }
-    
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto it = found.find(keys[i]);
+        if (it != found.end()) {
+            ret[i] = it->second;
+        }
+    }
+    return ret;
 }
 
 bool MySQLConnector::set(const std::string& _key, const std::string& _value) {
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "INSERT INTO ? (`key`,`value`) VALUES (?,?) ON DUPLICATE KEY UPDATE value = VALUES(value)";
-
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, _key);
-    statement->set_string(2, _value);
-    return statement->execute();
-
+    return this->__run(Statement::SET, [&_key, &_value](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
+        statement->set_string(1, _value);
+        // an unchanged value affects no rows, only errors count
+        statement->execute();
+        return statement->error_no() == 0;
+    });
 }
 
 bool MySQLConnector::setEx(const std::string& _key, int _ttl, const std::string& _value) {
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "INSERT INTO ? (`key`,`value`,`ttl`)VALUES(?,?,DATE_ADD(NOW(),INTERVAL ? SECOND)) ON DUPLICATE KEY UPDATE value = VALUES(value), ttl = VALUES(ttl)";
-
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, _key);
-    statement->set_string(2, _value);
-    statement->set_signed32(3, _ttl);
-    return statement->execute();
+    return this->__run(Statement::SET_EX, [&_key, _ttl, &_value](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
+        statement->set_string(1, _value);
+        statement->set_signed32(2, _ttl);
+        statement->execute();
+        return statement->error_no() == 0;
+    });
 }
 
 bool MySQLConnector::expire(const std::string& _key, int _ttl) {
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "UPDATE ? SET `ttl`=DATE_ADD(NOW(),INTERVAL ? SECOND)) WHERE `key`=?";
+    return this->__run(Statement::EXPIRE, [&_key, _ttl](mariadb::statement_ref& statement) {
+        statement->set_signed32(0, _ttl);
+        statement->set_string(1, _key);
+        return statement->execute() > 0;
+    });
+}
 
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_unsigned32(1, _ttl);
-    statement->set_string(2, _key);
-    return statement->execute();
+bool MySQLConnector::setMany(const std::vector<DBKeyValue>& entries) {
+
+    if (!this->con) throw std::runtime_error("Mysql DB undefined");
+
+    return this->__writeMany(entries, false, [](mariadb::statement_ref& statement, uint32_t& param, const DBKeyValue& entry) {
+        statement->set_string(param++, entry.first);
+        statement->set_string(param++, entry.second);
+    });
+}
+
+bool MySQLConnector::setExMany(const std::vector<DBKeyEntry>& entries) {
+
+    if (!this->con) throw std::runtime_error("Mysql DB undefined");
+
+    return this->__writeMany(entries, true, [](mariadb::statement_ref& statement, uint32_t& param, const DBKeyEntry& entry) {
+        statement->set_string(param++, entry.first);
+        statement->set_string(param++, entry.second.first);
+        // NULL ttl, the row does not expire
+        if (entry.second.second < 0) {
+            statement->set_null(param++);
+        }
+        else {
+            statement->set_signed32(param++, entry.second.second);
+        }
+    });
 }
 
 bool MySQLConnector::exists(const std::string& _key) {
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "SELECT `value` FROM ? WHERE `key`=? AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
-
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, _key);
-    auto res = statement->query();
-    if (!res || res->error_no() != 0 || res->row_count() == 0) {
-        return false;
-    }
-    else {
-        return true;
-    }
+    return this->__run(Statement::EXISTS, [&_key](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
 
+        auto res = statement->query();
+        return res && res->error_no() == 0 && res->row_count() > 0;
+    });
 }
 
 bool MySQLConnector::del(const std::string& _key) {
     
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
 
-    std::string execQry = "DELETE FROM ? WHERE `key`=?";
-
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->config.dbname);
-    statement->set_string(1, this->defaultKeyValTableName);
-    return statement->execute();
-
+    return this->__run(Statement::DEL, [&_key](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
+        return statement->execute() > 0;
+    });
 }
 
 std::string MySQLConnector::ping() {
     
-    if (!this->con) "false";
+    if (!this->con) return "false";
 
     return std::to_string(con->connected());
 
@@ -268,19 +568,15 @@ int MySQLConnector::ttl(const std::string& _key) {
 
     if (!this->con) throw std::runtime_error("Mysql DB undefined");
     
-    std::string execQry = "SELECT UNIX_TIMESTAMP(`ttl`), UNIX_TIMESTAMP(CURRENT_TIMESTAMP()) FROM ? WHERE `key`=? AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
-    
-    auto statement = con->create_statement(execQry);
-    statement->set_string(0, this->defaultKeyValTableName);
-    statement->set_string(1, _key);
-    auto res = statement->query();
-    if (!res || res->error_no() != 0 || res->row_count() == 0) {
-        if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
-        return -1;
-    }
-    else {
-        return res->get_signed64(0) - res->get_signed64(1);
-    }
+    return this->__run(Statement::TTL, [this, &_key](mariadb::statement_ref& statement) {
+        statement->set_string(0, _key);
 
+        auto res = statement->query();
+        if (!res || res->error_no() != 0 || !res->next()) {
+            if (extendedLogging) WARNING("Call failed: " + (res ? res->error() : "empty result"));
+            return -1;
+        }
+        return res->get_is_null(0) ? -1 : static_cast<int>(res->get_signed64(0));
+    });
 }
 
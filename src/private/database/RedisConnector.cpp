@@ -1,10 +1,15 @@
 #include <database/RedisConnector.hpp>
 
 #include <sstream>
+#include <algorithm>
+#include <unordered_set>
 
 using namespace std::literals::string_literals;
 
-RedisConnector::RedisConnector(const DBConfig& Config) {
+RedisConnector::RedisConnector(const DBConfig& config) :
+    pipelined(config.redisPipeline),
+    replyTimeout(config.redisReplyTimeoutMs)
+{
     this->config = config;
 
     
@@ -36,13 +41,30 @@ RedisConnector::~RedisConnector() {
     
 }
 
+void RedisConnector::__commit() {
+    if (this->pipelined) {
+        // other callers may have queued commands meanwhile, they are sent along
+        this->client->commit();
+    }
+    else {
+        this->client->sync_commit();
+    }
+}
+
+cpp_redis::reply RedisConnector::__await(std::future<cpp_redis::reply>& reply) {
+    if (reply.wait_for(this->replyTimeout) != std::future_status::ready) {
+        throw std::runtime_error("Redis reply timed out");
+    }
+    return reply.get();
+}
+
 #define EXEC_COMMAND(command, default_return, result_op) try {\
 if (!this->client->is_connected()) {\
     throw std::runtime_error("Redis client could not connect");\
 }\
 auto resp = this->client->command;\
-this->client->sync_commit();\
-auto result = resp.get();\
+this->__commit();\
+auto result = this->__await(resp);\
 if (result.is_error() || result.is_null()) {\
     return default_return;\
 }\
@@ -52,33 +74,74 @@ catch (cpp_redis::redis_error& e) {\
     return default_return;\
 }
 
+/**
+*  \brief MATCH pattern that matches the prefix literally
+**/
+static std::string matchPrefix(const std::string& prefix) {
+    std::string ret;
+    ret.reserve(prefix.size() + 2);
+    for (char c : prefix) {
+        if (c == '*' || c == '?' || c == '[' || c == ']' || c == '\\') {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    ret += '*';
+    return ret;
+}
+
 std::vector<std::string> RedisConnector::keys(const std::string& prefix) {
 
+    // SCAN instead of KEYS, which blocks the server until all keys are listed
+    std::vector<std::string> ret;
+    std::unordered_set<std::string> seen;
+    std::string cursor;
+    do {
+        auto page = this->scanKeys(prefix, cursor, 1000);
+        for (auto& x : page.second) {
+            // SCAN may return a key more than once
+            if (seen.insert(x).second) {
+                ret.emplace_back(std::move(x));
+            }
+        }
+        cursor = std::move(page.first);
+    } while (!cursor.empty());
+
+    return ret;
+}
+
+DBKeyPage RedisConnector::scanKeys(const std::string& prefix, const std::string& cursor, size_t count) {
+
+    DBKeyPage ret;
+
     try {
         if (!this->client->is_connected()) {
             throw std::runtime_error("Redis client could not connect");
         }
-        auto resp = this->client->keys(prefix + "*");
-        this->client->sync_commit();
-        auto result = resp.get();
-        if (result.is_error() || result.is_null()) {
-            return {};
-        }
 
-        std::vector<std::string> ret;
-        auto array = result.as_array();
-        ret.reserve(array.size());
-
-        for (auto&x : array) {
-            ret.emplace_back(x.as_string());
+        std::size_t position = cursor.empty() ? 0 : std::stoull(cursor);
+        auto resp = this->client->scan(position, matchPrefix(prefix), std::max<size_t>(count, 1));
+        this->__commit();
+        auto result = this->__await(resp);
+        // an empty page with cursor "" would end the listing as if it was complete
+        if (result.is_error() || !result.is_array() || result.as_array().size() != 2) {
+            throw std::runtime_error("Key listing failed: " + (result.is_error() ? result.error() : "unexpected SCAN reply"s));
         }
 
+        auto& array = result.as_array();
+        // the server is done when it returns cursor 0
+        if (array[0].as_string() != "0") {
+            ret.first = array[0].as_string();
+        }
+        ret.second.reserve(array[1].as_array().size());
+        for (auto& x : array[1].as_array()) {
+            ret.second.emplace_back(x.as_string());
+        }
         return ret;
     }
     catch (cpp_redis::redis_error& e) {
-        return {};
+        throw std::runtime_error("Key listing failed: "s + e.what());
     }
-
 }
 
 std::string RedisConnector::get(const std::string& key) {
@@ -94,7 +157,139 @@ std::string RedisConnector::getRange(const std::string& key, unsigned int from,
 }
 
 std::pair<std::string, int> RedisConnector::getWithTtl(const std::string& key) {
-    return { this->get(key), this->ttl(key) };
+
+    try {
+        if (!this->client->is_connected()) {
+            throw std::runtime_error("Redis client could not connect");
+        }
+
+        // GET and TTL in one round trip
+        auto valueResp = this->client->get(key);
+        auto ttlResp = this->client->ttl(key);
+        this->__commit();
+        auto value = this->__await(valueResp);
+        auto ttl = this->__await(ttlResp);
+
+        std::pair<std::string, int> ret("", -1);
+        if (!value.is_error() && value.is_string()) {
+            ret.first = value.as_string();
+        }
+        if (!ttl.is_error() && ttl.is_integer()) {
+            ret.second = std::max(static_cast<int>(ttl.as_integer()), -1);
+        }
+        return ret;
+    }
+    catch (cpp_redis::redis_error& e) {
+        return { "", -1 };
+    }
+}
+
+std::vector<std::string> RedisConnector::getMany(const std::vector<std::string>& keys) {
+
+    std::vector<std::string> ret(keys.size());
+    if (keys.empty()) return ret;
+
+    try {
+        if (!this->client->is_connected()) {
+            throw std::runtime_error("Redis client could not connect");
+        }
+        auto resp = this->client->mget(keys);
+        this->__commit();
+        auto result = this->__await(resp);
+        // "" would read as "not found" for every key of the batch
+        if (result.is_error() || !result.is_array() || result.as_array().size() != keys.size()) {
+            throw std::runtime_error("Multi get failed: " + (result.is_error() ? result.error() : "unexpected MGET reply"s));
+        }
+
+        auto& array = result.as_array();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            // missing keys are nil
+            if (array[i].is_string()) {
+                ret[i] = array[i].as_string();
+            }
+        }
+        return ret;
+    }
+    catch (cpp_redis::redis_error& e) {
+        throw std::runtime_error("Multi get failed: "s + e.what());
+    }
+}
+
+DBEntryPage RedisConnector::scanEntries(const std::string& prefix, const std::string& cursor, size_t count) {
+
+    DBEntryPage ret;
+
+    // errors are not swallowed here, a partial load would be taken for the whole keyspace
+    try {
+        if (!this->client->is_connected()) {
+            throw std::runtime_error("Redis client could not connect");
+        }
+
+        // SCAN does not block the server like KEYS, the page is fetched with one pipelined MGET + PTTLs
+        std::size_t position = cursor.empty() ? 0 : std::stoull(cursor);
+        auto scanResp = this->client->scan(position, matchPrefix(prefix), std::max<size_t>(count, 1));
+        this->__commit();
+        auto scanResult = this->__await(scanResp);
+        if (scanResult.is_error() || !scanResult.is_array() || scanResult.as_array().size() != 2) {
+            throw std::runtime_error("Bulk load failed: " + (scanResult.is_error() ? scanResult.error() : "unexpected SCAN reply"s));
+        }
+
+        auto& array = scanResult.as_array();
+        // the server is done when it returns cursor 0
+        if (array[0].as_string() != "0") {
+            ret.first = array[0].as_string();
+        }
+
+        std::vector<std::string> page;
+        page.reserve(array[1].as_array().size());
+        for (auto& x : array[1].as_array()) {
+            page.emplace_back(x.as_string());
+        }
+        // redis may return empty pages before the last one
+        if (page.empty()) {
+            return ret;
+        }
+
+        auto valuesResp = this->client->mget(page);
+        std::vector< std::future<cpp_redis::reply> > ttlResps;
+        ttlResps.reserve(page.size());
+        for (auto& key : page) {
+            ttlResps.emplace_back(this->client->pttl(key));
+        }
+        this->__commit();
+
+        auto values = this->__await(valuesResp);
+        if (values.is_error() || !values.is_array() || values.as_array().size() != page.size()) {
+            throw std::runtime_error("Bulk load failed: " + (values.is_error() ? values.error() : "unexpected MGET reply"s));
+        }
+
+        auto& valueArray = values.as_array();
+        ret.second.reserve(page.size());
+        for (size_t i = 0; i < page.size(); ++i) {
+            auto ttl = this->__await(ttlResps[i]);
+            if (ttl.is_error()) {
+                throw std::runtime_error("Bulk load failed: " + ttl.error());
+            }
+
+            // deleted in between
+            if (valueArray[i].is_null() || !valueArray[i].is_string()) {
+                continue;
+            }
+
+            // pttl is -1 if the key does not expire, round the remaining ms up
+            int ttlSeconds = -1;
+            if (ttl.is_integer() && ttl.as_integer() >= 0) {
+                ttlSeconds = static_cast<int>((ttl.as_integer() + 999) / 1000);
+            }
+
+            ret.second.emplace_back(std::move(page[i]), std::pair<std::string, int>(valueArray[i].as_string(), ttlSeconds));
+        }
+    }
+    catch (cpp_redis::redis_error& e) {
+        throw std::runtime_error("Bulk load failed: "s + e.what());
+    }
+
+    return ret;
 }
 
 bool RedisConnector::set(const std::string& key, const std::string& value) {
@@ -109,6 +304,49 @@ bool RedisConnector::setEx(const std::string& key, int ttl, const std::string& v
 
 }
 
+bool RedisConnector::setMany(const std::vector<DBKeyValue>& entries) {
+
+    if (entries.empty()) return true;
+
+    EXEC_COMMAND(mset(entries), false, true)
+
+}
+
+bool RedisConnector::setExMany(const std::vector<DBKeyEntry>& entries) {
+
+    if (entries.empty()) return true;
+
+    // one script instead of MULTI / EXEC, other callers of a shared connection can not end up inside the transaction
+    static const std::string script =
+        "for i = 1, #KEYS do "
+            "local ttl = tonumber(ARGV[2 * i]) "
+            "if ttl < 0 then redis.call('SET', KEYS[i], ARGV[2 * i - 1]) "
+            "else redis.call('SETEX', KEYS[i], ttl, ARGV[2 * i - 1]) end "
+        "end "
+        "return #KEYS";
+
+    // SETEX fails on a ttl of 0, the script would stop after the entries before it
+    for (auto& entry : entries) {
+        if (entry.second.second == 0) {
+            WARNING("Multi SETEX rejected, ttl 0 of key " + entry.first);
+            return false;
+        }
+    }
+
+    std::vector<std::string> keys;
+    std::vector<std::string> args;
+    keys.reserve(entries.size());
+    args.reserve(entries.size() * 2);
+    for (auto& entry : entries) {
+        keys.emplace_back(entry.first);
+        args.emplace_back(entry.second.first);
+        args.emplace_back(std::to_string(entry.second.second));
+    }
+
+    EXEC_COMMAND(eval(script, static_cast<int>(keys.size()), keys, args), false, true)
+
+}
+
 bool RedisConnector::expire(const std::string& key, int ttl) {
 
     EXEC_COMMAND(expire(key, ttl), false, result.as_integer())
@@ -139,3 +377,112 @@ int RedisConnector::ttl(const std::string& key) {
     EXEC_COMMAND(ttl(key), -1, std::max((int)result.as_integer(), -1))
 
 }
+
+/**
+*  \brief Reply callback that hands resultOp(reply) to done, defaultReturn on nil replies
+*
+*  Error replies (including the "network failure" of a dropped connection) complete the call as failed.
+**/
+template<typename T, typename F>
+static cpp_redis::client::reply_callback_t completeWith(DBCompletion<T>&& done, T defaultReturn, F resultOp) {
+    return [done = std::move(done), defaultReturn = std::move(defaultReturn), resultOp](cpp_redis::reply& result) {
+        if (result.is_error() || result.is_null()) {
+            if (result.is_error()) {
+                WARNING("Redis call failed: " + result.error());
+            }
+            T ret = defaultReturn;
+            done(std::move(ret), result.is_error());
+            return;
+        }
+        done(resultOp(result), false);
+    };
+}
+
+#define EXEC_ASYNC(command) \
+if (!this->client->is_connected()) {\
+    throw std::runtime_error("Redis client could not connect");\
+}\
+this->client->command;\
+this->client->commit();
+
+void RedisConnector::getAsync(const std::string& key, DBCompletion<std::string>&& done) {
+
+    EXEC_ASYNC(get(key, completeWith<std::string>(std::move(done), "", [](cpp_redis::reply& result) { return result.as_string(); })))
+
+}
+
+void RedisConnector::getWithTtlAsync(const std::string& key, DBCompletion<std::pair<std::string, int>>&& done) {
+
+    if (!this->client->is_connected()) {
+        throw std::runtime_error("Redis client could not connect");
+    }
+
+    // replies arrive in order, the TTL reply completes the call
+    struct Reply {
+        std::string value;
+        bool failed = false;
+    };
+    auto reply = std::make_shared<Reply>();
+    this->client->get(key, [reply](cpp_redis::reply& result) {
+        if (result.is_error()) {
+            WARNING("Redis call failed: " + result.error());
+            reply->failed = true;
+        }
+        else if (result.is_string()) {
+            reply->value = result.as_string();
+        }
+    });
+    this->client->ttl(key, [reply, done = std::move(done)](cpp_redis::reply& result) {
+        int ttl = -1;
+        if (result.is_error()) {
+            WARNING("Redis call failed: " + result.error());
+            reply->failed = true;
+        }
+        else if (result.is_integer()) {
+            ttl = std::max(static_cast<int>(result.as_integer()), -1);
+        }
+        if (reply->failed) {
+            done(std::pair<std::string, int>("", -1), true);
+            return;
+        }
+        done(std::pair<std::string, int>(std::move(reply->value), ttl), false);
+    });
+    this->client->commit();
+
+}
+
+void RedisConnector::existsAsync(const std::string& key, DBCompletion<bool>&& done) {
+
+    EXEC_ASYNC(exists({ key }, completeWith<bool>(std::move(done), false, [](cpp_redis::reply& result) { return result.as_integer() != 0; })))
+
+}
+
+void RedisConnector::setAsync(const std::string& key, const std::string& value, DBCompletion<bool>&& done) {
+
+    EXEC_ASYNC(set(key, value, completeWith<bool>(std::move(done), false, [](cpp_redis::reply& result) { return true; })))
+
+}
+
+void RedisConnector::setExAsync(const std::string& key, int ttl, const std::string& value, DBCompletion<bool>&& done) {
+
+    EXEC_ASYNC(setex(key, ttl, value, completeWith<bool>(std::move(done), false, [](cpp_redis::reply& result) { return true; })))
+
+}
+
+void RedisConnector::expireAsync(const std::string& key, int ttl, DBCompletion<bool>&& done) {
+
+    EXEC_ASYNC(expire(key, ttl, completeWith<bool>(std::move(done), false, [](cpp_redis::reply& result) { return result.as_integer() != 0; })))
+
+}
+
+void RedisConnector::delAsync(const std::string& key, DBCompletion<bool>&& done) {
+
+    EXEC_ASYNC(del({ key }, completeWith<bool>(std::move(done), false, [](cpp_redis::reply& result) { return result.as_integer() != 0; })))
+
+}
+
+void RedisConnector::ttlAsync(const std::string& key, DBCompletion<int>&& done) {
+
+    EXEC_ASYNC(ttl(key, completeWith<int>(std::move(done), -1, [](cpp_redis::reply& result) { return std::max(static_cast<int>(result.as_integer()), -1); })))
+
+}
@@ -1,8 +1,27 @@
 
 #include <database/SQLiteConnector.hpp>
 
+#include <unordered_map>
+#include <algorithm>
+
 using namespace std::literals::string_literals;
 
+namespace SQLiteCon_Detail {
+    // LIKE pattern that matches the prefix literally, special characters are escaped with a backslash
+    std::string likePrefix(const std::string& prefix) {
+        std::string ret;
+        ret.reserve(prefix.size() + 2);
+        for (char c : prefix) {
+            if (c == '%' || c == '_' || c == '\\') {
+                ret += '\\';
+            }
+            ret += c;
+        }
+        ret += '%';
+        return ret;
+    }
+};
+
 SQLiteConnector::SQLiteConnector(const DBConfig& config) {
     this->config = config;
 
@@ -105,6 +124,47 @@ std::vector< std::string > SQLiteConnector::keys(const std::string& prefix) {
     }
 }
 
+DBKeyPage SQLiteConnector::scanKeys(const std::string& prefix, const std::string& cursor, size_t count) {
+
+    if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
+    count = std::max<size_t>(count, 1);
+
+    // keyset pagination: the cursor is the last key of the previous page, the primary key index is read from there on.
+    // One row more than asked tells whether there is a next page
+    std::string execQry = "SELECT key FROM "s + this->defaultKeyValTableName + " WHERE key LIKE ? ESCAPE '\\'";
+    if (!cursor.empty()) {
+        execQry += " AND key > ?";
+    }
+    execQry += " AND (ttl IS NULL OR ttl > strftime('%s','now')) ORDER BY key LIMIT " + std::to_string(count + 1);
+
+    DBKeyPage ret;
+
+    std::unique_lock<std::mutex> lock(this->holderRef->SQLiteDBMutex);
+
+    try {
+
+        SQLite::Statement query(*holderRef->SQLiteDB, execQry);
+        query.bind(1, SQLiteCon_Detail::likePrefix(prefix));
+        if (!cursor.empty()) {
+            query.bind(2, cursor);
+        }
+
+        while (query.executeStep()) {
+            ret.second.emplace_back(query.getColumn(0).getString());
+        }
+    }
+    catch (SQLite::Exception& e) {
+        // an empty page with cursor "" would end the listing as if it was complete
+        throw std::runtime_error("Key listing failed: "s + e.what());
+    }
+
+    if (ret.second.size() > count) {
+        ret.second.pop_back();
+        ret.first = ret.second.back();
+    }
+    return ret;
+}
+
 std::string SQLiteConnector::get(const std::string& key) {
     
     if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
@@ -162,6 +222,90 @@ std::pair<std::string, int> SQLiteConnector::getWithTtl(const std::string& key)
     }
 }
 
+DBEntryPage SQLiteConnector::scanEntries(const std::string& prefix, const std::string& cursor, size_t count) {
+
+    if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
+    count = std::max<size_t>(count, 1);
+
+    // keyset pagination like scanKeys, one query per page instead of one per key
+    std::string execQry = "SELECT key, value, ttl - strftime('%s','now') FROM "s + this->defaultKeyValTableName + " WHERE key LIKE ? ESCAPE '\\'";
+    if (!cursor.empty()) {
+        execQry += " AND key > ?";
+    }
+    execQry += " AND (ttl IS NULL OR ttl > strftime('%s','now')) ORDER BY key LIMIT " + std::to_string(count + 1);
+
+    DBEntryPage ret;
+
+    std::unique_lock<std::mutex> lock(this->holderRef->SQLiteDBMutex);
+
+    try {
+
+        SQLite::Statement query(*holderRef->SQLiteDB, execQry);
+        query.bind(1, SQLiteCon_Detail::likePrefix(prefix));
+        if (!cursor.empty()) {
+            query.bind(2, cursor);
+        }
+
+        while (query.executeStep()) {
+            auto ttl = query.getColumn(2);
+            ret.second.emplace_back(
+                query.getColumn(0).getString(),
+                std::pair<std::string, int>(query.getColumn(1).getString(), ttl.isNull() ? -1 : ttl.getInt())
+            );
+        }
+    }
+    catch (SQLite::Exception& e) {
+        // a partial load would be taken for the whole keyspace
+        throw std::runtime_error("Bulk load failed: "s + e.what());
+    }
+
+    if (ret.second.size() > count) {
+        ret.second.pop_back();
+        ret.first = ret.second.back().first;
+    }
+    return ret;
+}
+
+std::vector<std::string> SQLiteConnector::getMany(const std::vector<std::string>& keys) {
+    if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
+    if (keys.empty()) return {};
+
+    std::string execQry = "SELECT key, value FROM "s + this->defaultKeyValTableName + " WHERE key IN (";
+    for (size_t i = 0; i < keys.size(); ++i) {
+        execQry += i > 0 ? ",?" : "?";
+    }
+    execQry += ") AND (ttl IS NULL OR ttl > strftime('%s','now'))";
+
+    std::vector<std::string> ret(keys.size());
+
+    std::unique_lock<std::mutex> lock(this->holderRef->SQLiteDBMutex);
+
+    try {
+
+        SQLite::Statement query(*holderRef->SQLiteDB, execQry);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            query.bind(static_cast<int>(i) + 1, keys[i]);
+        }
+
+        std::unordered_map<std::string, std::string> found;
+        while (query.executeStep()) {
+            found.emplace(query.getColumn(0).getString(), query.getColumn(1).getString());
+        }
+
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto it = found.find(keys[i]);
+            if (it != found.end()) {
+                ret[i] = it->second;
+            }
+        }
+        return ret;
+    }
+    catch (SQLite::Exception& e) {
+        // "" would read as "not found" for every key of the batch
+        throw std::runtime_error("Multi get failed: "s + e.what());
+    }
+}
+
 bool SQLiteConnector::exists(const std::string& key) {
     if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
 
@@ -223,6 +367,66 @@ bool SQLiteConnector::setEx(const std::string& key, int ttl, const std::string&
     }
 }
 
+bool SQLiteConnector::setMany(const std::vector<DBKeyValue>& entries) {
+    if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
+    if (entries.empty()) return true;
+
+    std::unique_lock<std::mutex> lock(this->holderRef->SQLiteDBMutex);
+
+    try {
+
+        // one transaction instead of one journal sync per row, rolled back if a row throws
+        SQLite::Transaction transaction(*holderRef->SQLiteDB);
+        SQLite::Statement query(*holderRef->SQLiteDB, "INSERT OR REPLACE INTO "s + this->defaultKeyValTableName + " (key,value) VALUES (?,?)");
+        for (auto& entry : entries) {
+            query.bind(1, entry.first);
+            query.bind(2, entry.second);
+            query.exec();
+            query.reset();
+        }
+        transaction.commit();
+
+        return true;
+    }
+    catch (SQLite::Exception& e) {
+        WARNING("Query failed: "s + e.what());
+        return false;
+    }
+}
+
+bool SQLiteConnector::setExMany(const std::vector<DBKeyEntry>& entries) {
+    if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
+    if (entries.empty()) return true;
+
+    std::unique_lock<std::mutex> lock(this->holderRef->SQLiteDBMutex);
+
+    try {
+
+        SQLite::Transaction transaction(*holderRef->SQLiteDB);
+        SQLite::Statement query(*holderRef->SQLiteDB, "INSERT OR REPLACE INTO "s + this->defaultKeyValTableName + " (key,value,ttl) VALUES (?,?, strftime('%s','now') + ?)");
+        for (auto& entry : entries) {
+            query.bind(1, entry.first);
+            query.bind(2, entry.second.first);
+            // NULL ttl, the row does not expire
+            if (entry.second.second < 0) {
+                query.bind(3);
+            }
+            else {
+                query.bind(3, entry.second.second);
+            }
+            query.exec();
+            query.reset();
+        }
+        transaction.commit();
+
+        return true;
+    }
+    catch (SQLite::Exception& e) {
+        WARNING("Query failed: "s + e.what());
+        return false;
+    }
+}
+
 bool SQLiteConnector::expire(const std::string& key, int ttl) {
     if (!this->holderRef || !this->holderRef->SQLiteDB) throw std::runtime_error("SQLite DB undefined");
 
@@ -231,8 +435,8 @@ bool SQLiteConnector::expire(const std::string& key, int ttl) {
     try {
 
         SQLite::Statement query(*holderRef->SQLiteDB, "UPDATE "s + this->defaultKeyValTableName + " SET ttl=strftime('%s','now')+? WHERE key=?");
-        query.bind(1, key);
-        query.bind(2, ttl);
+        query.bind(1, ttl);
+        query.bind(2, key);
 
         return query.exec() != 0;
     }
@@ -0,0 +1,59 @@
+#include <epochserver/ResultBufferPool.hpp>
+
+ResultBufferPool::ResultBufferPool(size_t maxRetainedBytes) : maxRetainedBytes(maxRetainedBytes) {}
+
+std::string ResultBufferPool::acquire(size_t capacity) {
+
+    // smallest class that fits
+    size_t sizeClass = minClass;
+    while (sizeClass <= maxClass && (static_cast<size_t>(1) << sizeClass) < capacity) {
+        ++sizeClass;
+    }
+
+    if (sizeClass > maxClass) {
+        std::string buffer;
+        buffer.reserve(capacity);
+        return buffer;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto& list = this->freeLists[sizeClass - minClass];
+        if (!list.empty()) {
+            std::string buffer = std::move(list.back());
+            list.pop_back();
+            this->retainedBytes -= buffer.capacity();
+            return buffer;
+        }
+    }
+
+    std::string buffer;
+    buffer.reserve(static_cast<size_t>(1) << sizeClass);
+    return buffer;
+}
+
+void ResultBufferPool::release(std::string&& buffer) {
+
+    size_t capacity = buffer.capacity();
+    if (capacity < (static_cast<size_t>(1) << minClass)) {
+        return;
+    }
+
+    // largest class that is completely covered
+    size_t sizeClass = minClass;
+    while (sizeClass < maxClass && (static_cast<size_t>(1) << (sizeClass + 1)) <= capacity) {
+        ++sizeClass;
+    }
+    if (capacity >= (static_cast<size_t>(1) << (maxClass + 1))) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex, std::try_to_lock);
+    if (!lock.owns_lock() || this->retainedBytes + capacity > this->maxRetainedBytes) {
+        return;
+    }
+
+    buffer.clear();
+    this->retainedBytes += capacity;
+    this->freeLists[sizeClass - minClass].emplace_back(std::move(buffer));
+}
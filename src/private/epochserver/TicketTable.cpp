@@ -0,0 +1,95 @@
+#include <epochserver/TicketTable.hpp>
+
+TicketTable::TicketTable() : slots(new Slot[capacity]) {
+    this->freeSlots.reserve(capacity);
+    // hand out low indices first
+    for (unsigned int i = capacity; i > 0; --i) {
+        this->freeSlots.emplace_back(i - 1);
+    }
+}
+
+void TicketTable::__free(unsigned int index) {
+    Slot& slot = this->slots[index];
+    slot.result.buffer = std::string();
+    slot.result.offset = 0;
+    slot.state.store(SLOT_FREE, std::memory_order_relaxed);
+    this->freeSlots.emplace_back(index);
+}
+
+void TicketTable::__reclaimStale() {
+    for (unsigned int i = 0; i < capacity; ++i) {
+        Slot& slot = this->slots[i];
+        if (slot.state.load(std::memory_order_acquire) == SLOT_READY && utils::seconds_since(slot.readyAt) > staleSeconds) {
+            this->__free(i);
+        }
+    }
+}
+
+DBTicket TicketTable::reserve() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->freeSlots.empty()) {
+        this->__reclaimStale();
+        if (this->freeSlots.empty()) {
+            throw std::runtime_error("Too many pending tickets");
+        }
+    }
+
+    unsigned int index = this->freeSlots.back();
+    this->freeSlots.pop_back();
+
+    Slot& slot = this->slots[index];
+    slot.generation = (slot.generation + 1) & ((1u << generationBits) - 1);
+    slot.state.store(SLOT_PENDING, std::memory_order_relaxed);
+
+    return (slot.generation << indexBits) | index;
+}
+
+void TicketTable::fulfill(DBTicket ticket, std::string&& result) {
+    Slot& slot = this->slots[ticket & (capacity - 1)];
+
+    slot.result.buffer = std::move(result);
+    slot.result.offset = 0;
+    slot.readyAt = utils::sysclock::now();
+    slot.state.store(SLOT_READY, std::memory_order_release);
+}
+
+void TicketTable::cancel(DBTicket ticket) {
+    unsigned int index = ticket & (capacity - 1);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    Slot& slot = this->slots[index];
+    if (slot.state.load(std::memory_order_acquire) != SLOT_PENDING || slot.generation != (ticket >> indexBits)) {
+        return;
+    }
+    this->__free(index);
+}
+
+int TicketTable::poll(DBTicket ticket, char* output, int outputSize, ResultBufferPool& pool) {
+    output[0] = '\0';
+
+    unsigned int index = ticket & (capacity - 1);
+    if ((ticket >> indexBits) >= (1u << generationBits)) {
+        return 103;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    Slot& slot = this->slots[index];
+    uint8_t state = slot.state.load(std::memory_order_acquire);
+    if (state == SLOT_FREE || slot.generation != (ticket >> indexBits)) {
+        return 103; // unknown / already collected
+    }
+    if (state == SLOT_PENDING) {
+        return 102; // not ready yet
+    }
+
+    if (slot.result.writeChunk(output, outputSize, 0)) {
+        return 100; // Split msg
+    }
+
+    pool.release(std::move(slot.result.buffer));
+    this->__free(index);
+    return 0;
+}
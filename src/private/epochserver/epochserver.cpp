@@ -2,6 +2,7 @@
 #include <external/md5.hpp>
 
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <cctype>
 #include <algorithm>
@@ -147,7 +148,9 @@ void EpochServer::__setupRCON(const rapidjson::Value& config) {
 
                     this->whitelist->enable_vpn_detection(
                         /* api key */ apikey,
-                        /* kicksuspecious */ vpnObj.HasMember("kicksuspecious") && vpnObj["kicksuspecious"].GetBool()
+                        /* kicksuspecious */ vpnObj.HasMember("kicksuspecious") && vpnObj["kicksuspecious"].GetBool(),
+                        /* threads */ vpnObj.HasMember("threads") ? vpnObj["threads"].GetUint() : 2,
+                        /* queueMax */ vpnObj.HasMember("queueMax") ? vpnObj["queueMax"].GetUint() : 256
                     );
 
                     if (vpnObj.HasMember("exceptions")) {
@@ -214,6 +217,11 @@ void EpochServer::__setupSteamAPI(const rapidjson::Value& config) {
         throw std::runtime_error("Steam API key must be set if you want to use this feature");
     }
     this->steamApi = std::make_shared<SteamAPI>(apikey);
+    this->steamApiExecutor = std::make_unique<Executor>(
+        "steamapi",
+        config.HasMember("threads") ? config["threads"].GetUint() : 2,
+        config.HasMember("queueMax") ? config["queueMax"].GetUint() : 256
+    );
 
     this->steamApi->setSteamApiLogLevel(config.HasMember("loglevel") ? config["loglevel"].GetInt() : 0);
     this->steamApi->setMinDaysSinceLastVacBan(config.HasMember("mindayssincelastban") ? config["mindayssincelastban"].GetInt() : -1);
@@ -227,12 +235,152 @@ EpochServer::~EpochServer() {}
 
 void EpochServer::insertCallback(const SQFCallBackHandle& cb) {
 
-    std::string x;
+    std::string x = this->resultBuffers.acquire(cb.stringSize());
     cb.toString(x);
-    std::pair<std::string, size_t> pair{ x, 0 };
 
-    std::unique_lock<std::mutex> lock(this->resultsMutex);
-    this->results.emplace(pair);
+    this->results.push(std::move(x));
+}
+
+DBTicket EpochServer::reserveTicket() {
+    return this->tickets.reserve();
+}
+
+void EpochServer::cancelTicket(DBTicket ticket) {
+    this->tickets.cancel(ticket);
+}
+
+void EpochServer::insertTicketResult(DBTicket ticket, const DBReturn& result) {
+
+    size_t sizeHint = 64;
+    if (result.index() == 0) {
+        sizeHint += std::get<std::string>(result).size();
+    }
+    else if (result.index() == 3) {
+        sizeHint += std::get<std::pair<std::string, int>>(result).first.size();
+    }
+    else if (result.index() == 5) {
+        auto& page = std::get<DBKeyPage>(result);
+        sizeHint += page.first.size();
+        for (auto& x : page.second) {
+            sizeHint += x.size() + 3;
+        }
+    }
+
+    std::string x = this->resultBuffers.acquire(sizeHint);
+    DBWorker::formatResult(result, x);
+
+    this->tickets.fulfill(ticket, std::move(x));
+}
+
+int EpochServer::__pollTicket(char* output, int outputSize, const char **args, int argsCnt) {
+
+    if (outputSize < 3 || argsCnt < 1) {
+        if (outputSize > 0) output[0] = '\0';
+        return 103; // Error
+    }
+
+    try {
+        DBTicket ticket = static_cast<DBTicket>(std::stoul(args[0]));
+        return this->tickets.poll(ticket, output, outputSize, this->resultBuffers);
+    }
+    catch (...) {
+        output[0] = '\0';
+        return 103; // Error
+    }
+}
+
+int EpochServer::__deliverChunk(std::optional<ResultDelivery>& delivery, char* output, int outputSize, size_t written) {
+
+    auto& res = *delivery;
+
+    if (res.writeChunk(output, outputSize, written)) {
+        return 100; // Split msg
+    }
+
+    // done -> recycle
+    this->resultBuffers.release(std::move(res.buffer));
+    delivery.reset();
+    return 0;
+}
+
+int EpochServer::__pollResult(char* output, int outputSize) {
+
+    if (outputSize < 3) {
+        if (outputSize > 0) output[0] = '\0';
+        return 103; // Error
+    }
+
+    try {
+        if (!this->currentResult) {
+            std::string next;
+            if (!this->results.pop(next)) {
+                output[0] = '\0';
+                return 101; // Empty
+            }
+            this->currentResult.emplace(ResultDelivery{ std::move(next), 0 });
+        }
+        return this->__deliverChunk(this->currentResult, output, outputSize, 0);
+    }
+    catch (...) {
+        this->currentResult.reset();
+        output[0] = '\0';
+        return 103; // Error
+    }
+}
+
+int EpochServer::__pollResultsBatched(char* output, int outputSize) {
+
+    if (outputSize < 3) {
+        if (outputSize > 0) output[0] = '\0';
+        return 103; // Error
+    }
+
+    try {
+        // finish the array that is already in delivery first
+        if (this->currentBatch) {
+            return this->__deliverChunk(this->currentBatch, output, outputSize, 0);
+        }
+
+        size_t chunkSize = static_cast<size_t>(outputSize) - 1;
+        size_t pos = 0;
+        size_t count = 0;
+        std::string next;
+
+        output[pos++] = '[';
+        while (this->results.pop(next)) {
+            if (count > 0) {
+                output[pos++] = ',';
+            }
+            ++count;
+
+            // closing bracket has to fit as well
+            if (pos + next.size() + 1 <= chunkSize) {
+                std::memcpy(output + pos, next.data(), next.size());
+                pos += next.size();
+                this->resultBuffers.release(std::move(next));
+            }
+            else {
+                // last one does not fit -> deliver the batch in chunks, only this result gets split
+                next.push_back(']');
+                this->currentBatch.emplace(ResultDelivery{ std::move(next), 0 });
+                return this->__deliverChunk(this->currentBatch, output, outputSize, pos);
+            }
+        }
+
+        if (count == 0) {
+            output[0] = '\0';
+            return 101; // Empty
+        }
+
+        output[pos++] = ']';
+        output[pos] = '\0';
+        return 0;
+    }
+    catch (...) {
+        this->currentBatch.reset();
+        output[0] = '\0';
+        return 103; // Error
+    }
 }
 
 std::string EpochServer::getRandomString() {
@@ -313,6 +461,62 @@ void EpochServer::log(const std::string& log) {
     INFO(log);
 }
 
+std::string EpochServer::getStats() {
+    auto stats = this->dbManager->getStats();
+    if (this->steamApiExecutor) {
+        this->steamApiExecutor->appendStats(stats, "steamapi");
+    }
+    if (this->whitelist) {
+        this->whitelist->append_vpn_stats(stats);
+    }
+
+    std::string out = "[";
+    for (size_t i = 0; i < stats.size(); ++i) {
+        if (i > 0) {
+            out += ",";
+        }
+        out += "[\"";
+        out += stats[i].first;
+        out += "\",";
+        out += std::to_string(stats[i].second);
+        out += "]";
+    }
+    out += "]";
+    return out;
+}
+
+std::string EpochServer::getCacheStatus() {
+    auto status = this->dbManager->getCacheStatus();
+
+    std::string out = "[";
+    for (size_t i = 0; i < status.size(); ++i) {
+        if (i > 0) {
+            out += ",";
+        }
+        out += "[\"";
+        out += status[i].name;
+        out += "\",\"";
+        switch (status[i].state) {
+            case DBCache::State::COLD: out += "cold"; break;
+            case DBCache::State::WARMING: out += "warming"; break;
+            case DBCache::State::WARM: out += "warm"; break;
+        }
+        out += "\",";
+        out += std::to_string(status[i].keys);
+        out += ",";
+        out += std::to_string(status[i].warmupMs);
+        out += "]";
+    }
+    out += "]";
+    return out;
+}
+
+void EpochServer::flushWrites() {
+    if (this->dbManager) {
+        this->dbManager->closeWriteBuffers();
+    }
+}
+
 #define SET_RESULT(x,y) outCode = x; out = y;
 #define STR_MOVE(x) std::move(std::string(x))
 #define THROW_ARGS_INVALID_NUM(x) throw std::runtime_error("Invalid number of args for "s + x)
@@ -323,38 +527,33 @@ int EpochServer::callExtensionEntrypoint(char *output, int outputSize, const cha
     std::string out;
     int outCode = 0;
 
-    size_t fncLen = strlen(function);
-
     try {
-        if (fncLen == 2) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, function, args, argsCnt);
-        }
-        else if (!strncmp(function, "db", 2)) {
-            this->dbEntrypoint(out, outputSize, outCode, function, args, argsCnt);
-        }
-        else if (!strncmp(function, "be", 2)) {
-            this->beEntrypoint(out, outputSize, outCode, function, args, argsCnt);
-        }
-        else if (!strcmp(function, "playerCheck")) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, "30", args, argsCnt);
-        }
-        else if (!strcmp(function, "log")) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, "91", args, argsCnt);
+        // db calls can choose their priority with a suffix: "dbGet:low", "13:high"
+        std::string_view name(function);
+        std::optional<DBWorker::PriorityScope> priority;
+        size_t separator = name.rfind(':');
+        if (separator != std::string_view::npos) {
+            priority.emplace(Executor::parsePriority(name.substr(separator + 1)));
+            name = name.substr(0, separator);
         }
-        else if (!strcmp(function, "getCurrentTime")) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, "00", args, argsCnt);
+
+        // names and numbers are resolved by the compile time perfect hash (see epochserver/Dispatch.hpp)
+        const char* code = dispatch::lookup(name);
+        if (!code) {
+            SET_RESULT(1, "Unknown function");
         }
-        else if (!strcmp(function, "getRandomString")) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, "01", args, argsCnt);
+        // callback polls write straight into the output buffer
+        else if (code[0] == '9' && code[1] == '0') {
+            return this->__pollResult(output, outputSize);
         }
-        else if (!strcmp(function, "getStringMd5")) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, "02", args, argsCnt);
+        else if (code[0] == '9' && code[1] == '2') {
+            return this->__pollResultsBatched(output, outputSize);
         }
-        else if (!strcmp(function, "version")) {
-            this->callExtensionEntrypointByNumber(out, outputSize, outCode, "90", args, argsCnt);
+        else if (code[0] == '9' && code[1] == '3') {
+            return this->__pollTicket(output, outputSize, args, argsCnt);
         }
         else {
-            SET_RESULT(1, "Unknown function");
+            this->callExtensionEntrypointByNumber(out, outputSize, outCode, code, args, argsCnt);
         }
     }
     catch (std::exception& e) {
@@ -370,38 +569,8 @@ void EpochServer::callExtensionEntrypointByNumber(std::string& out, int outputSi
         // extension info
         case '9': {
             switch (function[1]) {
-                // extension callback poll
-                case '0': {
-                    if (this->resultsMutex.try_lock()) {
-                        if (this->results.empty()) {
-                            outCode = 101; // Empty
-                        }
-                        else {
-                            try {
-                                auto& res = this->results.front();
-                                if ((res.first.size() - res.second) > outputSize) {
-                                    // split up
-                                    out = std::string(res.first, res.second, outputSize);
-                                    outCode = 100; // Split msg
-                                    res.second += outputSize;
-                                }
-                                else {
-                                    // done -> pop
-                                    out = std::string(res.first, res.second);
-                                    this->results.pop();
-                                }
-                            }
-                            catch (...) {
-                                outCode = 103; // Error
-                            }
-                        }
-                        this->resultsMutex.unlock();
-                    }
-                    else {
-                        outCode = 102; // Busy
-                    }
-                    break;
-                }
+                // 90 (callback poll), 92 (batched poll) and 93 (ticket poll) are handled in callExtensionEntrypoint
+
                 // log
                 case '1': {
                     if (argsCnt < 1) throw std::runtime_error("Nothing to log was provided");
@@ -446,7 +615,7 @@ void EpochServer::callExtensionEntrypointByNumber(std::string& out, int outputSi
                     SET_RESULT(1, "RCON NOT AVAILABLE");
                     return;
                 }
-                threadpool->fireAndForget([this, x = STR_MOVE(args[0])]() {
+                this->steamApiExecutor->fireAndForget([this, x = STR_MOVE(args[0])]() {
                     std::string err;
                     if (this->steamApi && this->rcon && !this->steamApi->initialPlayerCheck(x, err)) {
                         auto guid = this->__getBattlEyeGUID(std::stoull(x));
@@ -461,8 +630,74 @@ void EpochServer::callExtensionEntrypointByNumber(std::string& out, int outputSi
         break;
     }
     
+    // db (ticketed)
+    case '4': {
+        this->dbTicketEntrypoint(out, outputSize, outCode, function[1], args, argsCnt);
+        break;
+    }
+
+    // stats
+    case '5': {
+        switch (function[1]) {
+            // db stats
+            case '0': {
+                SET_RESULT(0, this->getStats());
+                break;
+            }
+            // cache warm-up status
+            case '1': {
+                SET_RESULT(0, this->getCacheStatus());
+                break;
+            }
+            default: { SET_RESULT(1, "Unknown function"); }
+        }
+        break;
+    }
+
+    // db key listing and bulk writes
+    case '6': {
+        switch (function[1]) {
+            // scan keys: connection, prefix, [cursor, [count]] -> ticket of ["nextCursor",[keys]], nextCursor is "" on the last page, false if the listing failed
+            case '0': {
+                if (argsCnt < 2) THROW_ARGS_INVALID_NUM("scanKeys");
+                size_t count = argsCnt >= 4 ? std::stoul(args[3]) : 100;
+                // pages are delivered in one piece, keep them to a sane size
+                count = std::min<size_t>(std::max<size_t>(count, 1), 1000);
+                DBTicket ticket = this->dbManager->scanKeys<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]), argsCnt >= 3 ? STR_MOVE(args[2]) : "", count);
+                SET_RESULT(0, std::to_string(ticket));
+                break;
+            }
+            // set many: connection, key, value, key, value, .. -> ticket of true if all were written (one transaction)
+            case '1': {
+                if (argsCnt < 3 || (argsCnt - 1) % 2 != 0) THROW_ARGS_INVALID_NUM("setMany");
+                std::vector<DBKeyValue> entries;
+                entries.reserve((argsCnt - 1) / 2);
+                for (int i = 1; i < argsCnt; i += 2) {
+                    entries.emplace_back(args[i], args[i + 1]);
+                }
+                DBTicket ticket = this->dbManager->setMany<DBExecutionType::ASYNC_POLL>(args[0], std::move(entries));
+                SET_RESULT(0, std::to_string(ticket));
+                break;
+            }
+            // setEx many: connection, key, ttl, value, key, ttl, value, .. -> ticket of true if all were written (one transaction)
+            case '2': {
+                if (argsCnt < 4 || (argsCnt - 1) % 3 != 0) THROW_ARGS_INVALID_NUM("setExMany");
+                std::vector<DBKeyEntry> entries;
+                entries.reserve((argsCnt - 1) / 3);
+                for (int i = 1; i < argsCnt; i += 3) {
+                    entries.emplace_back(args[i], std::pair<std::string, int>(args[i + 2], std::stoi(args[i + 1])));
+                }
+                DBTicket ticket = this->dbManager->setExMany<DBExecutionType::ASYNC_POLL>(args[0], std::move(entries));
+                SET_RESULT(0, std::to_string(ticket));
+                break;
+            }
+            default: { SET_RESULT(1, "Unknown function"); }
+        }
+        break;
+    }
+
     /////////////////////////////
-    // 4-8 TODO
+    // 7-8 TODO
     /////////////////////////////
 
 
@@ -493,7 +728,63 @@ void EpochServer::callExtensionEntrypointByNumber(std::string& out, int outputSi
     };
 }
 
+bool EpochServer::__serveFromCache(std::string& out, int outputSize, int& outCode, const char function, const char *workerName, const char *key) {
+
+    // quotes and brackets around the value + terminator
+    size_t maxSize = outputSize > 32 ? static_cast<size_t>(outputSize) - 32 : 0;
+
+    std::string result;
+
+    auto entry = this->dbManager->getCached(workerName, key, maxSize);
+    if (!entry) {
+        if (!this->dbManager->isKnownAbsent(workerName, key)) {
+            return false;
+        }
+
+        // same results as the database gives for a missing key
+        switch (function) {
+            case '1': DBWorker::formatResult(DBReturn(std::string()), result); break;
+            case '2': DBWorker::formatResult(DBReturn(std::pair<std::string, int>("", -1)), result); break;
+            case '6': DBWorker::formatResult(DBReturn(false), result); break;
+            default: return false;
+        }
+        SET_RESULT(2, std::move(result)); // Cache hit (absent)
+        return true;
+    }
+
+    switch (function) {
+        // get
+        case '1': {
+            DBWorker::formatResult(DBReturn(std::move(entry->first)), result);
+            break;
+        }
+        // getTtl
+        case '2': {
+            DBWorker::formatResult(DBReturn(std::move(*entry)), result);
+            break;
+        }
+        // exists
+        case '6': {
+            DBWorker::formatResult(DBReturn(true), result);
+            break;
+        }
+        default: {
+            return false;
+        }
+    }
+
+    SET_RESULT(2, std::move(result)); // Cache hit
+    return true;
+}
+
 void EpochServer::dbEntrypoint(std::string& out, int outputSize, int& outCode, const char function, const char **args, int argsCnt) {
+
+    // reads are answered right away if the value is cached
+    if ((function == '1' || function == '2' || function == '6') && argsCnt >= 2 &&
+        this->__serveFromCache(out, outputSize, outCode, function, args[0], args[1])) {
+        return;
+    }
+
     switch(function) {
         // get
         case '1': {
@@ -520,7 +811,10 @@ void EpochServer::dbEntrypoint(std::string& out, int outputSize, int& outCode, c
                   // set
         case '3': {
             if (argsCnt == 3) {
-                this->dbManager->set<DBExecutionType::ASYNC_CALLBACK>(args[0], STR_MOVE(args[1]), STR_MOVE(args[2]), std::nullopt, std::nullopt);
+                // fire and forget -> write-behind if enabled for this connection
+                if (!this->dbManager->bufferWrite(args[0], args[1], args[2], -1)) {
+                    this->dbManager->set<DBExecutionType::ASYNC_CALLBACK>(args[0], STR_MOVE(args[1]), STR_MOVE(args[2]), std::nullopt, std::nullopt);
+                }
             }
             else if (argsCnt >= 4) {
                 this->dbManager->set<DBExecutionType::ASYNC_CALLBACK>(args[0], STR_MOVE(args[1]), STR_MOVE(args[2]), STR_MOVE(args[3]), argsCnt >= 5 ? STR_MOVE(args[4]) : "[]");
@@ -532,7 +826,9 @@ void EpochServer::dbEntrypoint(std::string& out, int outputSize, int& outCode, c
         case '4': {
             if (argsCnt == 4) {
                 int ttl = std::stoi(args[2]);
-                this->dbManager->setEx<DBExecutionType::ASYNC_CALLBACK>(args[0], STR_MOVE(args[1]), ttl, STR_MOVE(args[3]), std::nullopt, std::nullopt);
+                if (!this->dbManager->bufferWrite(args[0], args[1], args[3], ttl)) {
+                    this->dbManager->setEx<DBExecutionType::ASYNC_CALLBACK>(args[0], STR_MOVE(args[1]), ttl, STR_MOVE(args[3]), std::nullopt, std::nullopt);
+                }
             }
             else if (argsCnt >= 5) {
                 int ttl = std::stoi(args[2]);
@@ -597,41 +893,84 @@ void EpochServer::dbEntrypoint(std::string& out, int outputSize, int& outCode, c
             else THROW_ARGS_INVALID_NUM("getRange");
             break;
         };
-                  // TODO
+                  // ping
         case '0': {
+            if (argsCnt < 1) THROW_ARGS_INVALID_NUM("ping");
+            this->dbManager->ping<DBExecutionType::ASYNC_CALLBACK>(args[0], std::nullopt, std::nullopt); // TODO callback
             break;
         };
         default: { SET_RESULT(1, "Unknown function"); };
     };
 }
 
-#define MAP_DB_ENTRY(name, number)\
-if (!strcmp(function, name)) {\
-    this->dbEntrypoint(out, outputSize, outCode, number, args, argsCnt);\
-    return;\
-}
-
-void EpochServer::dbEntrypoint(std::string& out, int outputSize, int& outCode, const char *function, const char **args, int argsCnt) {
-    
-    // skip prefix TODO test encoding.. might need to skipp more bytes
-    function += 2;
-
-    MAP_DB_ENTRY("Get", '1');
-    MAP_DB_ENTRY("Exists", '6');
-    MAP_DB_ENTRY("Set", '3');
-    MAP_DB_ENTRY("SetEx", '4');
-    MAP_DB_ENTRY("Expire", '7');
-    MAP_DB_ENTRY("Del", '8');
-    MAP_DB_ENTRY("Query", '5');
-    MAP_DB_ENTRY("GetTtl", '2');
-    MAP_DB_ENTRY("GetRange", '9');
-    
-    if (!strcmp(function, "Ping")) { // TODO callback
-        this->dbManager->ping<DBExecutionType::ASYNC_CALLBACK>(args[0], std::nullopt, std::nullopt);
-    }
-    else {
-        SET_RESULT(1, "Unknown db command");
-    }
+void EpochServer::dbTicketEntrypoint(std::string& out, int outputSize, int& outCode, const char function, const char **args, int argsCnt) {
+    DBTicket ticket;
+    switch(function) {
+        // get
+        case '1': {
+            if (argsCnt < 2) THROW_ARGS_INVALID_NUM("get");
+            ticket = this->dbManager->get<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]));
+            break;
+        };
+                  // getTtl
+        case '2': {
+            if (argsCnt < 2) THROW_ARGS_INVALID_NUM("getTtl");
+            ticket = this->dbManager->getWithTtl<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]));
+            break;
+        };
+                  // set
+        case '3': {
+            if (argsCnt < 3) THROW_ARGS_INVALID_NUM("set");
+            ticket = this->dbManager->set<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]), STR_MOVE(args[2]));
+            break;
+        };
+                  // setEx
+        case '4': {
+            if (argsCnt < 4) THROW_ARGS_INVALID_NUM("setEx");
+            int ttl = std::stoi(args[2]);
+            ticket = this->dbManager->setEx<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]), ttl, STR_MOVE(args[3]));
+            break;
+        };
+                  // Exists
+        case '6': {
+            if (argsCnt < 2) THROW_ARGS_INVALID_NUM("exists");
+            ticket = this->dbManager->exists<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]));
+            break;
+        };
+                  // Expire
+        case '7': {
+            if (argsCnt < 3) THROW_ARGS_INVALID_NUM("expire");
+            int ttl = std::stoi(args[2]);
+            ticket = this->dbManager->expire<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]), ttl);
+            break;
+        };
+                  // del
+        case '8': {
+            if (argsCnt < 2) THROW_ARGS_INVALID_NUM("del");
+            ticket = this->dbManager->del<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]));
+            break;
+        };
+                  // getRange
+        case '9': {
+            if (argsCnt < 4) THROW_ARGS_INVALID_NUM("getRange");
+            unsigned long from, to;
+            from = std::stoul(args[2]);
+            to = std::stoul(args[3]);
+            ticket = this->dbManager->getRange<DBExecutionType::ASYNC_POLL>(args[0], STR_MOVE(args[1]), from, to);
+            break;
+        };
+                  // ping
+        case '0': {
+            if (argsCnt < 1) THROW_ARGS_INVALID_NUM("ping");
+            ticket = this->dbManager->ping<DBExecutionType::ASYNC_POLL>(args[0]);
+            break;
+        };
+        default: {
+            SET_RESULT(1, "Unknown function");
+            return;
+        };
+    };
+    SET_RESULT(0, std::to_string(ticket));
 }
 
 void EpochServer::beEntrypoint(std::string& out, int outputSize, int& outCode, const char function, const char **args, int argsCnt) {
@@ -701,28 +1040,3 @@ void EpochServer::beEntrypoint(std::string& out, int outputSize, int& outCode, c
         }
     }
 }
-
-#define MAP_BE_ENTRY(name, number)\
-if (!strcmp(function, name)) {\
-    this->beEntrypoint(out, outputSize, outCode, number, args, argsCnt);\
-    return;\
-}
-
-void EpochServer::beEntrypoint(std::string& out, int outputSize, int& outCode, const char *function, const char **args, int argsCnt) {
-
-    if (!this->rcon) {
-        SET_RESULT(1, "RCON NOT AVAILABLE");
-        return;
-    }
-
-    MAP_BE_ENTRY("beBroadcastMessage", '0');
-    MAP_BE_ENTRY("beKick", '1');
-    MAP_BE_ENTRY("beBan", '2');
-    MAP_BE_ENTRY("beShutdown", '5');
-    MAP_BE_ENTRY("beLock", '3');
-    MAP_BE_ENTRY("beUnlock", '4');
-
-    // No matches
-    SET_RESULT(1, "Unknown be command");
-
-}
@@ -0,0 +1,156 @@
+#include <threading/Executor.hpp>
+#include <main.hpp>
+
+#include <algorithm>
+
+thread_local const Executor* Executor::current = nullptr;
+
+Executor::Executor(const std::string& name, size_t threads, size_t capacity, std::chrono::milliseconds agingStep) :
+    name(name),
+    capacity(capacity),
+    agingStep(std::max(agingStep, std::chrono::milliseconds(1)))
+{
+    threads = std::max<size_t>(threads, 1);
+    this->workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        this->workers.emplace_back(&Executor::__run, this);
+    }
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->available.notify_all();
+    for (auto& x : this->workers) {
+        if (x.joinable()) {
+            x.join();
+        }
+    }
+}
+
+void Executor::__push(std::function<void()>&& fnc, Priority priority) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->stop) {
+            throw std::runtime_error("Executor " + this->name + " is stopped");
+        }
+        if (this->capacity > 0 && this->queued >= this->capacity) {
+            ++this->rejected;
+            throw std::runtime_error("Queue of " + this->name + " is full (" + std::to_string(this->capacity) + " tasks)");
+        }
+        this->lanes[static_cast<size_t>(priority)].push_back({ std::move(fnc), std::chrono::steady_clock::now() });
+        ++this->queued;
+        this->maxQueued = std::max(this->maxQueued, this->queued);
+    }
+    this->available.notify_one();
+}
+
+size_t Executor::__nextLane() {
+    size_t best = laneCount;
+    std::chrono::steady_clock::time_point bestDue;
+    // the fronts are the oldest tasks of their lanes, only they have to be compared
+    for (size_t lane = 0; lane < laneCount; ++lane) {
+        if (this->lanes[lane].empty()) continue;
+
+        auto due = this->lanes[lane].front().queuedAt + this->agingStep * static_cast<int>(lane);
+        if (best == laneCount || due < bestDue) {
+            best = lane;
+            bestDue = due;
+        }
+    }
+    return best;
+}
+
+void Executor::__run() {
+    current = this;
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->available.wait(lock, [this]() { return this->stop || this->queued > 0; });
+            // queued tasks are still run on stop
+            if (this->queued == 0) return;
+
+            auto now = std::chrono::steady_clock::now();
+            size_t lane = this->__nextLane();
+            for (size_t higher = 0; higher < lane; ++higher) {
+                if (!this->lanes[higher].empty()) {
+                    ++this->aged;
+                    break;
+                }
+            }
+
+            task = std::move(this->lanes[lane].front());
+            this->lanes[lane].pop_front();
+            --this->queued;
+
+            uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - task.queuedAt).count());
+            ++this->executed[lane];
+            this->waitMicros[lane] += micros;
+            this->maxWaitMicros[lane] = std::max(this->maxWaitMicros[lane], micros);
+        }
+
+        try {
+            task.fnc();
+        }
+        catch (std::exception& e) {
+            WARNING("Task on " + this->name + " failed: " + e.what());
+        }
+        catch (...) {
+            WARNING("Task on " + this->name + " failed");
+        }
+    }
+}
+
+Executor::Stats Executor::getStats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Stats stats{};
+    stats.threads = this->workers.size();
+    stats.queued = this->queued;
+    stats.maxQueued = this->maxQueued;
+    stats.rejected = this->rejected;
+    stats.aged = this->aged;
+    for (size_t lane = 0; lane < laneCount; ++lane) {
+        stats.lanes[lane] = LaneStats{
+            this->lanes[lane].size(),
+            this->executed[lane],
+            this->waitMicros[lane],
+            this->maxWaitMicros[lane]
+        };
+        stats.executed += this->executed[lane];
+        stats.waitMicros += this->waitMicros[lane];
+        stats.maxWaitMicros = std::max(stats.maxWaitMicros, this->maxWaitMicros[lane]);
+    }
+    return stats;
+}
+
+void Executor::appendStats(std::vector<std::pair<std::string, uint64_t>>& out, const std::string& prefix) {
+    static const char* laneNames[laneCount] = { "High", "Normal", "Low" };
+
+    auto s = this->getStats();
+    out.emplace_back(prefix + ".execThreads", s.threads);
+    out.emplace_back(prefix + ".execQueued", s.queued);
+    out.emplace_back(prefix + ".execQueuedMax", s.maxQueued);
+    out.emplace_back(prefix + ".execExecuted", s.executed);
+    out.emplace_back(prefix + ".execRejected", s.rejected);
+    out.emplace_back(prefix + ".execAged", s.aged);
+    out.emplace_back(prefix + ".execWaitUsAvg", s.executed > 0 ? s.waitMicros / s.executed : 0);
+    out.emplace_back(prefix + ".execWaitUsMax", s.maxWaitMicros);
+    for (size_t lane = 0; lane < laneCount; ++lane) {
+        auto& l = s.lanes[lane];
+        std::string name = prefix + ".exec" + laneNames[lane];
+        out.emplace_back(name + "Queued", l.queued);
+        out.emplace_back(name + "Executed", l.executed);
+        out.emplace_back(name + "WaitUsAvg", l.executed > 0 ? l.waitMicros / l.executed : 0);
+        out.emplace_back(name + "WaitUsMax", l.maxWaitMicros);
+    }
+}
+
+Executor::Priority Executor::parsePriority(const std::string_view& str) {
+    if (str == "high") return Priority::HIGH;
+    if (str == "normal") return Priority::NORMAL;
+    if (str == "low") return Priority::LOW;
+    throw std::runtime_error("Unknown priority: " + std::string(str));
+}
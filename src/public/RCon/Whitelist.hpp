@@ -11,6 +11,7 @@
 #include <main.hpp>
 #include <RCon/RCON.hpp>
 #include <RCon/VPNDetection.hpp>
+#include <threading/Executor.hpp>
 
 class Whitelist {
 private:
@@ -36,6 +37,9 @@ private:
     std::unordered_set<std::string> vpn_whitelisted_guids;
     std::mutex vpn_whitelist_mutex;
 
+    // runs the vpn http checks, declared last so it is stopped before the members its tasks use
+    std::unique_ptr<Executor> vpn_executor;
+
     bool is_bad_player_string(const std::string& player_name) {
 
         for (int i = 0; i < player_name.length(); i++) {
@@ -92,12 +96,15 @@ public:
 
     // VPN DETECT
 
-    void enable_vpn_detection(const std::string& api_key, bool flag_if_suspecious = false);
+    // the checks run on their own executor (threads, queue_max: queued checks until new ones are skipped)
+    void enable_vpn_detection(const std::string& api_key, bool flag_if_suspecious = false, size_t threads = 2, size_t queue_max = 256);
 
     void set_vpn_detect_kick_msg(const std::string& _msg);
 
     void add_vpn_detection_guid_exception(const std::string& _guid);
 
+    void append_vpn_stats(std::vector<std::pair<std::string, uint64_t>>& _out);
+
     // rcon callbacks
     void on_player_connected(const RconPlayerInfo& info);
 
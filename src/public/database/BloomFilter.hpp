@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef __BLOOM_FILTER_HPP__
+#define __BLOOM_FILTER_HPP__
+
+#include <string>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/**
+*   \brief Bloom filter over cache keys
+*
+*   Sized for an expected number of keys at 10 bits per key with 7 probes (~1% false positives).
+*   Keys can only be added, so a "not contained" answer stays correct as long as every written key is added.
+*   Adding more keys than expected only raises the false positive rate.
+*
+*   add() and mayContain() may be called from any thread.
+**/
+class BloomFilter {
+private:
+
+    static constexpr unsigned int probes = 7;
+    static constexpr size_t bitsPerKey = 10;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+    size_t bitCount;
+
+    /**
+    *  \brief Two independent hashes of a key for double hashing
+    **/
+    static std::pair<uint64_t, uint64_t> __hash(const std::string& key);
+
+public:
+
+    BloomFilter(size_t expectedKeys);
+
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+    BloomFilter(BloomFilter&&) = delete;
+    BloomFilter& operator=(BloomFilter&&) = delete;
+
+    void add(const std::string& key);
+
+    /**
+    *  \return false if the key was never added
+    **/
+    bool mayContain(const std::string& key) const;
+
+    size_t sizeInBytes() const {
+        return this->bitCount / 8;
+    };
+};
+
+#endif // __BLOOM_FILTER_HPP__
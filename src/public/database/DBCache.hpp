@@ -0,0 +1,386 @@
+#pragma once
+
+#ifndef __DB_CACHE_HPP__
+#define __DB_CACHE_HPP__
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <database/DBConnector.hpp>
+#include <database/DBCacheStorage.hpp>
+#include <database/BloomFilter.hpp>
+#include <threading/TimingWheel.hpp>
+#include <main.hpp>
+
+/**
+*   \brief Read cache of one connection
+*
+*   Filled by a background warm-up, kept coherent by write-through from DBManager.
+*   Reads are only answered once the cache is warm, before that they fall through to the database.
+*   A COLD cache (not loaded or the warm-up failed) ignores writes.
+*   Keys that are written while the cache is warming are remembered, the loaded (older) values for them are skipped.
+*
+*   Expiring keys are scheduled in a timing wheel, evictExpired() removes everything that is due in one batch.
+*   The wheel links the entries themselves: a new deadline moves the entry, removing it cancels it.
+*
+*   Memory is bounded by maxBytes (0 = unbounded) with a segmented LRU: new entries start in the probation segment,
+*   a hit moves them to the protected segment (at most 80% of the budget). Evictions take the probation tail first,
+*   so a burst of one-time reads / loads can not flush the entries that are actually used.
+*   The budget counts the arena blocks of the entries and the map nodes and buckets (including the expiry links) as allocated.
+*   Not counted: the interned prefixes, the negative entries (at most maxAbsentKeysPerShard per shard),
+*   the keys written during the warm-up (dropped when it ends) and the key filter (reported as filterBytes).
+*
+*   Keys are stored as interned prefix ("Player" of "Player:123") and suffix, suffixes and values are
+*   kept in a slab arena per shard instead of separate heap strings.
+*
+*   The cache is split into shards by key hash, each with its own lock, segments, budget share and expiry wheel,
+*   so the game thread and the pool threads only contend if they hit the same shard.
+*   Most hits do not reorder the segments and only take the shard lock shared (see __needsPromotion).
+*
+*   Absent keys are answered without the database where that is safe (isAbsent()):
+*   - a Bloom filter over all loaded and written keys rules out keys that never existed
+*   - a shard that never had to evict still holds every key, a miss there is final
+*   Both need a warm-up that loaded every key, after a truncated load only cached values and negative entries are used.
+*   - "not found" results of the database are remembered for negativeTtl seconds (noteAbsent()).
+*     A read token taken when the read is issued drops results that raced with a write of the key.
+*
+*   All functions may be called from any thread.
+**/
+class DBCache {
+public:
+
+    enum class State {
+        COLD,
+        WARMING,
+        WARM
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions; /*!< removed to stay within the budget */
+        uint64_t expired;   /*!< removed by the expiry tick */
+        size_t keys;
+        size_t bytes;         /*!< accounted against the budget: entry blocks and map nodes, see the class description */
+        size_t reservedBytes; /*!< arena chunks, large values and map nodes */
+        size_t prefixes;      /*!< interned key prefixes over all shards */
+        uint64_t negativeHits; /*!< absent keys answered by the cache */
+        size_t negativeKeys;
+        size_t filterBytes;
+    };
+
+private:
+
+    struct Entry;
+    typedef std::pair<const CacheKey, Entry> Item;
+
+    struct Entry {
+        char* value;        /*!< arena block */
+        uint32_t valueSize;
+        int expiry;         /*!< absolute deadline in seconds since epoch, -1 if the key does not expire */
+        bool isProtected = false;
+        uint32_t promotedAt = 0; /*!< Shard::promotions when it was last moved to the protected head */
+        Item* prev = nullptr; /*!< neighbours in the lru segment */
+        Item* next = nullptr;
+        TimingWheelHook<Item> expiryHook; /*!< scheduled in the expiry wheel while expiry >= 0 */
+    };
+
+    struct ExpiryHookOf {
+        TimingWheelHook<Item>& operator()(Item* item) const {
+            return item->second.expiryHook;
+        }
+    };
+
+    typedef std::unordered_map<CacheKey, Entry, CacheKeyHash, std::equal_to<CacheKey>, CountingAllocator<Item>> EntryMap;
+
+    /**
+    *  \brief Intrusive lru list, head is the most recently used entry
+    **/
+    struct Segment {
+        Item* head = nullptr;
+        Item* tail = nullptr;
+
+        void pushFront(Item* item);
+        void unlink(Item* item);
+    };
+
+    /**
+    *  \brief Independent part of the cache, a key always lives in the same shard
+    *
+    *  Key suffixes and values live in the arena of the shard, the map only holds pointers into it.
+    *  Aligned to a cache line so the locks of neighbouring shards do not share one.
+    **/
+    struct alignas(64) Shard {
+        std::shared_mutex mutex; /*!< shared for lookups that change nothing */
+        PrefixTable prefixes;
+        SlabArena arena;
+        size_t mapBytes = 0; /*!< nodes and buckets of entries, counted by its allocator */
+        EntryMap entries{ 0, CacheKeyHash(), std::equal_to<CacheKey>(), CountingAllocator<Item>(&mapBytes) };
+        Segment probation;
+        Segment protectedSegment;
+
+        size_t maxBytes = 0;
+        size_t usedBytes = 0;      /*!< key suffix and value blocks of all entries */
+        size_t protectedBytes = 0; /*!< blocks of the protected entries */
+        size_t protectedCount = 0;
+        uint32_t promotions = 0;   /*!< moves to the protected head, wraps */
+
+        bool warming = false;                       /*!< writes are remembered in dirtyKeys, cleared with them at the end of the warm-up */
+        std::unordered_set<std::string> dirtyKeys; /*!< keys written during the warm-up */
+        TimingWheel<Item, ExpiryHookOf> expiryWheel{ now() };
+
+        std::unordered_map<std::string, int> absentKeys; /*!< key -> deadline of the negative entry */
+        bool complete = false;   /*!< holds every existing key of the shard (warm and never evicted) */
+        bool filtered = false;   /*!< writes have to be added to the key filter */
+        bool truncated = false;  /*!< an existing key was left out (budget) or evicted */
+    };
+
+    static constexpr size_t maxAbsentKeysPerShard = 4096;
+    static constexpr unsigned int writeSeqBits = 10;
+    static constexpr size_t writeSeqStripes = static_cast<size_t>(1) << writeSeqBits;
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardMask;
+
+    int negativeTtl;
+    std::unique_ptr<BloomFilter> keyFilter; /*!< built by finishWarmup after a complete load, else null */
+
+    /**
+    *  Write counters, striped by key hash. A write bumps the counter of its key,
+    *  a read result is only cached as absent if the counter did not change since the read was issued.
+    **/
+    std::atomic<uint64_t> writeSeqs[writeSeqStripes] = {};
+
+    std::atomic<State> state = State::COLD;
+    utils::timestamp warmupStart;
+    std::atomic<long long> warmupMs = -1;
+
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+    std::atomic<uint64_t> evictions = 0;
+    std::atomic<uint64_t> expired = 0;
+    std::atomic<uint64_t> negativeHits = 0;
+
+    Shard& __shardOf(const std::string& key) {
+        return this->shards[std::hash<std::string>{}(key) & this->shardMask];
+    }
+
+    size_t __shardCount() const {
+        return this->shardMask + 1;
+    }
+
+    std::atomic<uint64_t>& __writeSeqOf(const std::string& key) {
+        // the high bits of a 64 bit mix, independent of the low bits that pick the shard (size_t is 32 bit on x86)
+        uint64_t mixed = static_cast<uint64_t>(std::hash<std::string>{}(key)) * 0x9E3779B97F4A7C15ull;
+        return this->writeSeqs[mixed >> (64 - writeSeqBits)];
+    }
+
+    /**
+    *  Helpers, the mutex of the shard must be held for all of them
+    **/
+
+    /**
+    *  \brief Marks a key as written (dirty during the warm-up, added to the key filter, negative entry dropped)
+    **/
+    void __touch(Shard& shard, const std::string& key);
+
+    /**
+    *  \brief Remembers a key as absent for negativeTtl seconds
+    **/
+    void __putAbsent(Shard& shard, const std::string& key);
+
+    /**
+    *  \brief Schedules the expiry of an entry at its deadline, cancels it if it does not expire
+    **/
+    static void __schedule(Shard& shard, Item* item);
+
+    static size_t __entryBytes(const Item& item) {
+        return SlabArena::blockSize(item.first.suffixSize) + SlabArena::blockSize(item.second.valueSize);
+    }
+
+    /**
+    *  \brief Memory of the shard that counts against its budget: entry blocks, map nodes and buckets
+    *
+    *  Prefixes, absentKeys and dirtyKeys are small and bounded and left out.
+    **/
+    static size_t __bytes(const Shard& shard) {
+        return shard.usedBytes + shard.mapBytes;
+    }
+
+    /**
+    *  \brief Finds the entry of a key, end() if it is not cached
+    **/
+    static EntryMap::iterator __find(Shard& shard, const std::string& key);
+
+    /**
+    *  \brief Inserts or updates an entry, a new entry starts in the probation segment
+    *
+    *  Does not evict, callers check the budget afterwards.
+    **/
+    void __put(Shard& shard, const std::string& key, std::string_view value, int expiry);
+
+    /**
+    *  \brief Removes an entry from its segment and the map
+    **/
+    static void __erase(Shard& shard, EntryMap::iterator it);
+
+    /**
+    *  \brief Moves a hit entry to the head of the protected segment
+    **/
+    static void __promote(Shard& shard, EntryMap::iterator it);
+
+    /**
+    *  \brief Whether a hit has to move the entry, which needs the exclusive lock
+    *
+    *  - without a budget nothing is evicted and the order is never used
+    *  - a probation entry always moves to the protected segment
+    *  - a protected entry that at most a quarter of the segment was promoted past since its own promotion
+    *    is still in the first quarter (each promotion puts one entry in front of it) and stays
+    *  - further back, every fourth hit of the thread moves it, a hot entry still gets back to the head soon
+    **/
+    static bool __needsPromotion(const Shard& shard, const Entry& entry);
+
+    /**
+    *  \brief Lookup of get, promote: the exclusive lock is held and the entry is moved to the protected head
+    *
+    *  \return false if the hit needs a promotion and promote is false, out is not set then
+    **/
+    bool __lookup(Shard& shard, const std::string& key, size_t maxSize, bool promote, std::optional<std::pair<std::string, int>>& out);
+
+    /**
+    *  \brief Evicts from the segment tails until the budget of the shard is met
+    **/
+    void __evict(Shard& shard);
+
+    static void __clear(Shard& shard);
+
+public:
+
+    /**
+    *  \param maxBytes memory budget of the cache, 0 for unbounded
+    *  \param shardCount number of independently locked shards, rounded up to a power of two
+    *  \param negativeTtl seconds a "not found" result of the database is remembered, 0 to disable
+    **/
+    DBCache(size_t maxBytes = 0, size_t shardCount = 1, int negativeTtl = 5);
+    ~DBCache();
+
+    DBCache(const DBCache&) = delete;
+    DBCache& operator=(const DBCache&) = delete;
+    DBCache(DBCache&&) = delete;
+    DBCache& operator=(DBCache&&) = delete;
+
+    /**
+    *  \brief Current time in seconds since epoch, as used for the expiry
+    **/
+    static int now();
+
+    /**
+    *  \brief Looks up a key
+    *
+    *  Expired entries and values bigger than maxSize are treated as a miss, as is everything while the cache is not warm.
+    *
+    *  \return value and remaining ttl (-1 if it does not expire) on a hit
+    **/
+    std::optional<std::pair<std::string, int>> get(const std::string& key, size_t maxSize);
+
+    /**
+    *  \brief Checks whether a key is known to not exist (only when warm)
+    *
+    *  \return true if the key certainly does not exist in the database, false if unknown
+    **/
+    bool isAbsent(const std::string& key);
+
+    /**
+    *  \brief Token for a read of key that is issued now, see noteAbsent
+    **/
+    uint64_t readToken(const std::string& key) {
+        return this->__writeSeqOf(key).load();
+    };
+
+    /**
+    *  \brief The database did not find key, remembers that unless the key was written since the token was taken
+    **/
+    void noteAbsent(const std::string& key, uint64_t token);
+
+    /**
+    *  \brief A write of key reached the database, reads issued before it must not cache it as absent
+    **/
+    void writeDone(const std::string& key) {
+        ++this->__writeSeqOf(key);
+    };
+
+    /**
+    *  \brief Write-through of set (ttl -1) / setEx
+    **/
+    void set(const std::string& key, const std::string& value, int ttl);
+
+    /**
+    *  \brief Write-through of expire
+    **/
+    void expire(const std::string& key, int ttl);
+
+    /**
+    *  \brief Write-through of del
+    **/
+    void del(const std::string& key);
+
+    /**
+    *  \brief Forgets everything about a key, a write-through whose database call failed or was rejected
+    *
+    *  The database may hold the old or the new value now, the next read of the key goes to the database.
+    **/
+    void invalidate(const std::string& key);
+
+    /**
+    *  \brief Switches to WARMING, writes from now on are tracked
+    **/
+    void beginWarmup();
+
+    /**
+    *  \brief Inserts loaded entries (ttl relative) until the budget is reached
+    *
+    *  \return false if the budget was reached and entries were left out
+    **/
+    bool loadWarmup(std::vector<DBKeyEntry>&& loaded);
+
+    /**
+    *  \brief Switches to WARM
+    *
+    *  \param complete every key of the database was loaded without errors and within the budget,
+    *                  only then the key filter is built and misses may be answered as absent
+    **/
+    void finishWarmup(bool complete);
+
+    /**
+    *  \brief Warm-up failed, the cache stays COLD and empty
+    **/
+    void failWarmup();
+
+    /**
+    *  \brief Removes all entries whose deadline has passed (expiry tick)
+    *
+    *  \return number of removed entries
+    **/
+    size_t evictExpired();
+
+    State getState() const { return this->state.load(); };
+
+    /**
+    *  \brief Duration of the warm-up in ms, -1 while it is not done
+    **/
+    long long getWarmupMs() const { return this->warmupMs.load(); };
+
+    size_t size();
+
+    Stats getStats();
+};
+
+#endif // __DB_CACHE_HPP__
@@ -0,0 +1,202 @@
+#pragma once
+
+#ifndef __DB_CACHE_STORAGE_HPP__
+#define __DB_CACHE_STORAGE_HPP__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+/**
+*   \brief Slab allocator for the key suffixes and values of one cache shard
+*
+*   Allocations up to maxBlock bytes are rounded up to a size class and carved from 64 KB chunks:
+*   8 byte steps up to 128 bytes, above that four classes per power of two (at most 25% waste).
+*   freed blocks go to an intrusive free list of their class and are reused by the next allocation of that class.
+*   Bigger blocks (player blobs) are separate heap allocations.
+*   Chunks are only given back by clear(), large blocks only by release().
+*
+*   Not thread safe, the shard lock guards it.
+**/
+class SlabArena {
+private:
+
+    static constexpr size_t smallStep = 8;
+    static constexpr size_t smallLimit = 128;   /*!< 16 classes in 8 byte steps */
+    static constexpr size_t maxBlockBits = 12;  /*!< 4 KB */
+    static constexpr size_t classCount = smallLimit / smallStep + (maxBlockBits - 7) * 4;
+    static constexpr size_t chunkSize = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* chunkPos = nullptr;
+    char* chunkEnd = nullptr;
+
+    FreeBlock* freeLists[classCount] = {};
+
+    size_t largeBytes = 0;
+
+    static size_t __classOf(size_t size);
+    static size_t __classSize(size_t sizeClass);
+
+public:
+
+    static constexpr size_t maxBlock = static_cast<size_t>(1) << maxBlockBits;
+
+    SlabArena() {};
+    ~SlabArena() { this->clear(); };
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+    SlabArena(SlabArena&&) = delete;
+    SlabArena& operator=(SlabArena&&) = delete;
+
+    /**
+    *  \brief Bytes that are actually used for an allocation of the given size
+    **/
+    static size_t blockSize(size_t size);
+
+    /**
+    *  \brief Allocates a block for size bytes, nullptr for size 0
+    **/
+    char* allocate(size_t size);
+
+    /**
+    *  \brief Gives a block back, size must be the size it was allocated with
+    **/
+    void release(char* block, size_t size);
+
+    /**
+    *  \brief Frees all chunks, every small block handed out before is invalid afterwards
+    *
+    *  Large blocks must be released before.
+    **/
+    void clear();
+
+    /**
+    *  \brief Memory held by the arena (chunks and large blocks)
+    **/
+    size_t reservedBytes() const {
+        return this->chunks.size() * chunkSize + this->largeBytes;
+    };
+};
+
+/**
+*   \brief Allocator that keeps the bytes it currently has handed out in a counter
+*
+*   Used for the entry map of a shard, so nodes and buckets count against the budget exactly.
+*   Not thread safe, the shard lock guards the counter.
+**/
+template<typename T>
+struct CountingAllocator {
+    typedef T value_type;
+
+    size_t* counter;
+
+    explicit CountingAllocator(size_t* counter) noexcept : counter(counter) {};
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counter(other.counter) {};
+
+    T* allocate(size_t n) {
+        T* ret = std::allocator<T>().allocate(n);
+        *this->counter += n * sizeof(T);
+        return ret;
+    };
+
+    void deallocate(T* p, size_t n) noexcept {
+        *this->counter -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    };
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept {
+        return this->counter == other.counter;
+    };
+
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>& other) const noexcept {
+        return this->counter != other.counter;
+    };
+};
+
+/**
+*   \brief Cache key split into an interned prefix and its suffix
+*
+*   Epoch keys look like "Prefix:id", only a few dozen prefixes exist.
+*   Stored keys point into the arena, lookup keys point into the string that is looked up.
+**/
+struct CacheKey {
+    const char* suffix;
+    uint32_t suffixSize;
+    uint16_t prefix; /*!< 0 if the key has no prefix */
+
+    std::string_view suffixView() const {
+        return std::string_view(this->suffix, this->suffixSize);
+    };
+
+    bool operator==(const CacheKey& other) const {
+        return this->prefix == other.prefix && this->suffixView() == other.suffixView();
+    };
+};
+
+struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const {
+        return std::hash<std::string_view>{}(key.suffixView()) ^ (static_cast<size_t>(key.prefix) * 0x9E3779B97F4A7C15ull);
+    };
+};
+
+/**
+*   \brief Interned key prefixes of one cache shard
+*
+*   Not thread safe, the shard lock guards it.
+**/
+class PrefixTable {
+private:
+
+    std::deque<std::string> prefixes{ std::string() }; /*!< id -> prefix, id 0 is "no prefix" (deque, ids point into it) */
+    std::unordered_map<std::string_view, uint16_t> ids;
+
+public:
+
+    PrefixTable() {};
+
+    PrefixTable(const PrefixTable&) = delete;
+    PrefixTable& operator=(const PrefixTable&) = delete;
+    PrefixTable(PrefixTable&&) = delete;
+    PrefixTable& operator=(PrefixTable&&) = delete;
+
+    /**
+    *  \brief Splits a key at the first ':', the prefix is interned if it is new
+    *
+    *  If all prefix ids are taken the whole key is kept as suffix.
+    *  The suffix of the returned key still points into key.
+    **/
+    CacheKey intern(const std::string& key);
+
+    /**
+    *  \brief Splits a key without interning
+    *
+    *  \return false if the prefix is unknown, the key is not cached then
+    **/
+    bool find(const std::string& key, CacheKey& out) const;
+
+    /**
+    *  \brief Rebuilds the full key
+    **/
+    std::string toString(const CacheKey& key) const;
+
+    size_t size() const {
+        return this->prefixes.size() - 1;
+    };
+};
+
+#endif // __DB_CACHE_STORAGE_HPP__
@@ -36,6 +36,29 @@ struct DBConfig {
     std::string password;
 
     std::vector<DBSQLStatementTemplate> statements;
+
+    /*!< connection pool, see DBConnectionPool */
+    size_t poolMin = 0;                 /*!< opened at startup, 0 = poolMax */
+    size_t poolMax = 0;                 /*!< 0 = executorThreads + 1 (2 for pipelined redis), always 1 with redisAsync */
+    int poolIdleTimeout = 300;          /*!< seconds until idle connections above poolMin are closed */
+    int poolCheckoutTimeoutMs = 10000;
+
+    /*!< executor that runs the async calls of this connection, see Executor */
+    size_t executorThreads = 0;         /*!< 0 = global threadpool size */
+    size_t executorQueueMax = 10000;    /*!< queued calls until new ones are rejected, 0 = unbounded */
+    int executorAgingMs = 250;          /*!< wait time after which a queued call counts as one priority higher */
+
+    /*!< redis only: connections are shared and the commands of concurrent calls are pipelined, see RedisConnector */
+    bool redisPipeline = false;
+    int redisReplyTimeoutMs = 10000;        /*!< calls without reply after this fail, async calls as well (checked by the expiry tick, 0 = never for them) */
+    /*!< async calls are completed by the reply callbacks, no executor thread waits (implies redisPipeline)
+         all calls share one connection, so the commands of a key are applied in the order they were issued */
+    bool redisAsync = false;
+    size_t redisAsyncMaxInFlight = 10000;   /*!< async calls without reply until new ones are rejected, 0 = unbounded */
+
+    /*!< read batching, see DBReadBatcher */
+    size_t readBatchMax = 64;           /*!< keys per multi key fetch, 1 disables batching */
+    int readBatchWindowUs = 0;          /*!< time a batch stays open, 0 = only reads that queue up while the batch waits */
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+#pragma once
+
+#ifndef __DB_CONNECTION_POOL_HPP__
+#define __DB_CONNECTION_POOL_HPP__
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include <database/DBConfig.hpp>
+#include <database/DBConnector.hpp>
+#include <threading/Executor.hpp>
+#include <main.hpp>
+
+typedef std::shared_ptr<DBConnector> DBConRef;
+
+/**
+*   \brief Bounded pool of database connections of one DBWorker
+*
+*   Any thread checks a connection out for one call and gives it back afterwards (Lease).
+*   Idle connections are reused most recently returned first, so the ones that stay idle can be closed.
+*   If all poolMax connections are in use, checkout waits for one to come back (up to poolCheckoutTimeoutMs).
+*
+*   A maintenance thread keeps the pool healthy every few seconds:
+*   - idle connections above poolMin that were not used for poolIdleTimeout seconds are closed
+*   - idle connections are pinged once they were idle for a while, dead ones are closed
+*   - the pool is topped up to poolMin connections
+*   A connection whose call threw is pinged when it is given back and closed if that fails.
+*
+*   Shareable connectors (pipelined redis) stay in the pool while they are leased and while they are health checked,
+*   checkouts are spread over the open ones round robin and never wait for a connection to come back.
+**/
+class DBConnectionPool {
+public:
+
+    struct Stats {
+        size_t open;          /*!< idle, leased and connecting */
+        size_t idle;
+        uint64_t checkouts;
+        uint64_t waits;       /*!< checkouts that had to wait for a connection */
+        uint64_t waitMicros;  /*!< total time spent waiting in checkout */
+        uint64_t maxWaitMicros;
+        uint64_t created;
+        uint64_t closed;      /*!< reaped, unhealthy or failed */
+        uint64_t unhealthy;   /*!< failed health checks */
+        uint64_t connectMicros; /*!< total time spent connecting */
+        uint64_t maxConnectMicros;
+    };
+
+    /**
+    *  \brief Connection checked out of the pool, given back on destruction
+    **/
+    class Lease {
+    private:
+        DBConnectionPool* pool;
+        DBConRef connector;
+        bool suspect = false;
+
+    public:
+        Lease(DBConnectionPool* pool, DBConRef&& connector) : pool(pool), connector(std::move(connector)) {};
+        ~Lease();
+
+        Lease(Lease&& other) noexcept : pool(other.pool), connector(std::move(other.connector)), suspect(other.suspect) {
+            other.pool = nullptr;
+        };
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        const DBConRef& get() const { return this->connector; };
+        DBConnector* operator->() const { return this->connector.get(); };
+
+        /**
+        *  \brief The call failed, the connection is checked before it is reused
+        **/
+        void markSuspect() { this->suspect = true; };
+    };
+
+private:
+
+    struct IdleConnector {
+        DBConRef connector;
+        utils::timestamp since;
+        utils::timestamp lastCheck;
+    };
+
+    DBConfig dbConfig;
+    size_t minSize;
+    size_t maxSize;
+    std::chrono::seconds idleTimeout;
+    std::chrono::milliseconds checkoutTimeout;
+
+    static constexpr std::chrono::seconds maintenanceInterval{ 5 };
+    static constexpr std::chrono::seconds healthCheckAfter{ 30 };
+
+    std::mutex mutex;
+    std::condition_variable returned;
+    std::vector<IdleConnector> idle; /*!< most recently returned at the back, all open connections if shared */
+    size_t open = 0;
+    bool stop = false;
+
+    bool shared = false;    /*!< connectors are shareable (see DBConnector::isShareable) */
+    bool wanted = false;    /*!< tryCheckout found nothing, the maintenance opens at least one connection */
+    size_t nextShared = 0;  /*!< round robin position if shared */
+
+    std::thread maintenance;
+    std::condition_variable maintenanceCv;
+
+    std::atomic<uint64_t> checkouts = 0;
+    std::atomic<uint64_t> waits = 0;
+    std::atomic<uint64_t> waitMicros = 0;
+    std::atomic<uint64_t> maxWaitMicros = 0;
+    std::atomic<uint64_t> created = 0;
+    std::atomic<uint64_t> closed = 0;
+    std::atomic<uint64_t> unhealthy = 0;
+    std::atomic<uint64_t> connectMicros = 0;
+    std::atomic<uint64_t> maxConnectMicros = 0;
+
+    /**
+    *  \brief Opens minSize connections, the first one alone and the others in parallel on the executor
+    **/
+    void __preconnect(Executor& executor);
+
+    /**
+    *  \brief Opens a new connection (no lock held)
+    *
+    *  \throws std::runtime_error if the connection could not be created
+    **/
+    DBConRef __connect();
+
+    static bool __isHealthy(const DBConRef& connector);
+
+    void __giveBack(DBConRef&& connector, bool suspect);
+
+    /**
+    *  \brief Takes a dead shared connection out of the pool (no lock held)
+    **/
+    void __dropShared(const DBConRef& connector);
+
+    void __recordWait(const utils::timestamp& start, bool waited);
+
+    static void __recordMax(std::atomic<uint64_t>& max, uint64_t value);
+
+    void __runMaintenance();
+
+    /**
+    *  \brief Closes idle connections, pings the ones that were idle for long and tops the pool up to minSize
+    **/
+    void __maintain();
+
+public:
+
+    /**
+    *  \brief Opens minSize connections (see __preconnect)
+    *
+    *  \throws std::runtime_error if the first connection could not be created
+    **/
+    DBConnectionPool(const DBConfig& dbConfig, Executor& executor, size_t minSize, size_t maxSize, std::chrono::seconds idleTimeout, std::chrono::milliseconds checkoutTimeout);
+    ~DBConnectionPool();
+
+    DBConnectionPool(const DBConnectionPool&) = delete;
+    DBConnectionPool& operator=(const DBConnectionPool&) = delete;
+    DBConnectionPool(DBConnectionPool&&) = delete;
+    DBConnectionPool& operator=(DBConnectionPool&&) = delete;
+
+    /**
+    *  \brief Takes an idle connection, opens a new one or waits for one to be given back
+    *
+    *  \throws std::runtime_error on timeout or if no connection could be opened
+    **/
+    Lease checkout();
+
+    /**
+    *  \brief Takes an open connection without connecting or waiting (threads that must not block)
+    *
+    *  If there is none, the maintenance thread is woken up to open one.
+    *
+    *  \throws std::runtime_error if no connection is ready
+    **/
+    Lease tryCheckout();
+
+    Stats getStats();
+};
+
+#endif // __DB_CONNECTION_POOL_HPP__
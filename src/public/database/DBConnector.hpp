@@ -2,9 +2,40 @@
 #define __DB_CONNECTOR_H
 
 #include <vector>
+#include <string>
+#include <utility>
+#include <functional>
 
 #include <database/DBConfig.hpp>
 
+/**
+* Entry of a bulk load: key, (value, ttl)
+* ttl is -1 if the key does not expire
+**/
+typedef std::pair<std::string, std::pair<std::string, int> > DBKeyEntry;
+
+/**
+* Page of a key listing: cursor of the next page ("" after the last page), keys of this page
+**/
+typedef std::pair<std::string, std::vector<std::string> > DBKeyPage;
+
+/**
+* Page of a bulk load: cursor of the next page ("" after the last page), entries of this page
+**/
+typedef std::pair<std::string, std::vector<DBKeyEntry> > DBEntryPage;
+
+/**
+* Entry of a bulk write without ttl: key, value
+**/
+typedef std::pair<std::string, std::string> DBKeyValue;
+
+/**
+* Receives the result of an async call, failed if the command could not be sent or got an error reply (result is empty then)
+* Runs on the thread of the connector that received the reply
+**/
+template<typename T>
+using DBCompletion = std::function<void(T&& result, bool failed)>;
+
 /**
 *    Database Connector Interface
 *
@@ -24,6 +55,31 @@ public:
     virtual std::pair<std::string, int> getWithTtl(const std::string& key) = 0;
     virtual bool exists(const std::string& key) = 0;
 
+    /**
+    *  DB key listing in pages
+    *  Pass "" as cursor for the first page and the returned cursor for the next one
+    *  A page holds about count keys (redis may return fewer or none before the last page)
+    *  Keys that are added or removed during the listing may or may not be listed, redis may list a key twice
+    *  Throws on errors, an empty page with cursor "" always means the listing is complete
+    **/
+    virtual DBKeyPage scanKeys(const std::string& prefix, const std::string& cursor, size_t count) = 0;
+
+    /**
+    *  DB bulk load in pages
+    *  Like scanKeys, with value and ttl of every key. Used to fill the caches without holding the whole keyspace in memory
+    *  Default is scanKeys + getWithTtl per key, connectors override it with one round trip per page
+    *  Throws on errors instead of returning a partial page
+    **/
+    virtual DBEntryPage scanEntries(const std::string& prefix, const std::string& cursor, size_t count);
+
+    /**
+    *  DB multi GET
+    *  Values in the order of the keys, "" for keys that do not exist
+    *  Default is one get per key, connectors override it with a single round trip
+    *  Throws on errors, "" is only returned for keys that were looked up
+    **/
+    virtual std::vector<std::string> getMany(const std::vector<std::string>& keys);
+
     /**
     *  DB SET / SETEX
     *  Key
@@ -31,6 +87,15 @@ public:
     virtual bool set(const std::string& key, const std::string& value) = 0;
     virtual bool setEx(const std::string& key, int ttl, const std::string& value) = 0;
     virtual bool expire(const std::string& key, int ttl) = 0;
+
+    /**
+    *  DB multi SET / SETEX
+    *  All entries in one transaction, true if all were written
+    *  setExMany takes the ttl of each entry, entries with a ttl < 0 do not expire
+    *  Default is one set / setEx per entry (not atomic), connectors override it with a few round trips
+    **/
+    virtual bool setMany(const std::vector<DBKeyValue>& entries);
+    virtual bool setExMany(const std::vector<DBKeyEntry>& entries);
     
     /**
     *  DB DEL
@@ -53,5 +118,26 @@ public:
     *  DB Can execute SQL Query
     **/
     virtual bool canExecuteSQL() { return false; };
+
+    /**
+    *  Connector can run calls of several threads at the same time
+    *  The connection pool hands it to several callers then instead of one at a time
+    **/
+    virtual bool isShareable() { return false; };
+
+    /**
+    *  Connector implements the async calls below
+    *  They send the command and return at once, done is called with the reply
+    *  Defaults throw, callers check supportsAsync first
+    **/
+    virtual bool supportsAsync() { return false; };
+    virtual void getAsync(const std::string& key, DBCompletion<std::string>&& done);
+    virtual void getWithTtlAsync(const std::string& key, DBCompletion<std::pair<std::string, int>>&& done);
+    virtual void existsAsync(const std::string& key, DBCompletion<bool>&& done);
+    virtual void setAsync(const std::string& key, const std::string& value, DBCompletion<bool>&& done);
+    virtual void setExAsync(const std::string& key, int ttl, const std::string& value, DBCompletion<bool>&& done);
+    virtual void expireAsync(const std::string& key, int ttl, DBCompletion<bool>&& done);
+    virtual void delAsync(const std::string& key, DBCompletion<bool>&& done);
+    virtual void ttlAsync(const std::string& key, DBCompletion<int>&& done);
 };
 #endif // !__DB_CONNECTOR_H
@@ -6,6 +6,12 @@
 
 #include <main.hpp>
 #include <database/DBWorker.hpp>
+#include <database/DBWriteBuffer.hpp>
+#include <database/DBCache.hpp>
+
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
 #undef GetObject
 #include <rapidjson/rapidjson.h>
@@ -14,9 +20,7 @@
 #include <rapidjson/istreamwrapper.h>
 
 
-typedef std::unordered_map<std::string, std::pair<std::string, int> > DBEntryMap;
-typedef std::pair< std::shared_mutex, DBEntryMap > WorkerCache;
-typedef std::shared_ptr<WorkerCache> WorkerCacheRef;
+typedef std::shared_ptr<DBCache> WorkerCacheRef;
 typedef std::shared_ptr<DBWorker> WorkerRef;
 
 class DBManager {
@@ -25,12 +29,69 @@ private:
 
     std::vector< std::pair< std::string, WorkerRef > > dbWorkers;
     std::vector< std::pair< std::string, WorkerCacheRef > > dbWorkerCaches;
+    std::vector< std::pair< std::string, WriteBufferRef > > dbWriteBuffers;
+
+    /**
+    *  Expiry tick, evicts due cache entries and fails async calls without reply once per second
+    **/
+    std::thread expiryThread;
+    std::mutex expiryMutex;
+    std::condition_variable expiryCv;
+    bool stopExpiry = false;
+
+    void __runExpiry();
+
+    /**
+    *  Cache warm-ups in flight. They run on the executor of their worker and only hold a raw pointer to it,
+    *  so the last reference to a worker is never dropped on its own executor thread.
+    *  Declared after the workers: stopped and awaited before they are released, also if the constructor throws.
+    **/
+    struct Warmups {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t running = 0;
+        std::atomic<bool> stop = false;
+
+        /**
+        *  \brief Stops the running warm-ups after their current page and waits for all of them
+        **/
+        void stopAll();
+
+        ~Warmups() {
+            this->stopAll();
+        }
+    } warmups;
+
+    /**
+    *  \brief Fills the cache of a connection, runs on one of its executor threads
+    *
+    *  Pages are read on the calling thread and inserted by the other executor threads meanwhile.
+    *
+    *  \return false if it was stopped by the destructor, the cache holds a partial load then
+    *  \throws std::runtime_error if the load failed, the cache holds a partial load then
+    **/
+    bool __warmup(DBWorker& worker, const WorkerCacheRef& cache);
 
     WorkerCacheRef __getDbWorkerCache(const std::string& name);
     WorkerRef __getDbWorker(const std::string& name);
+    WriteBufferRef __getDbWriteBuffer(const std::string& name);
+
+    /**
+    *  \brief Hooks of the key functions, called before the call is issued
+    *
+    *  Keep cache (write-through) and write-behind buffer in line with direct calls.
+    *  The cache always reflects the last write that was issued through this manager.
+    **/
+    void __onSet(const std::string& workerName, const std::string& key, const std::string& value, int ttl);
+    void __onSetMany(const std::string& workerName, const std::vector<DBKeyValue>& entries);
+    void __onSetMany(const std::string& workerName, const std::vector<DBKeyEntry>& entries);
+    void __onExpire(const std::string& workerName, const std::string& key, int ttl);
+    void __onDel(const std::string& workerName, const std::string& key);
+    void __onRead(const std::string& workerName, const std::string& key);
 
 public:
     DBManager(const rapidjson::Value& cons);
+    ~DBManager();
 
     DBManager() = delete;
     DBManager(const DBManager&) = delete;
@@ -38,12 +99,56 @@ public:
     DBManager(DBManager&&) = delete;
     DBManager& operator=(DBManager&&) = delete;
 
+    /**
+    *  \brief Looks up a key in the worker cache (any thread)
+    *
+    *  Expired entries and values bigger than maxSize are treated as a miss.
+    *
+    *  \return value and remaining ttl (-1 if it does not expire) on a hit
+    **/
+    std::optional<std::pair<std::string, int>> getCached(const std::string& workerName, const std::string& key, size_t maxSize);
+
+    /**
+    *  \brief Checks whether the worker cache knows that a key does not exist (any thread)
+    **/
+    bool isKnownAbsent(const std::string& workerName, const std::string& key);
+
+    /**
+    *  \brief Fire and forget set (ttl -1) / setEx through the write-behind buffer of the connection
+    *
+    *  \return false if the connection has no buffer or it is full, the write has to be issued directly then
+    **/
+    bool bufferWrite(const std::string& workerName, const std::string& key, const std::string& value, int ttl);
+
+    /**
+    *  \brief Writes out all write-behind buffers and stops them (extensionDeInit)
+    **/
+    void closeWriteBuffers();
+
+    /**
+    *  \brief Counters of all connections as (name, value)
+    **/
+    std::vector<std::pair<std::string, uint64_t>> getStats();
+
+    struct CacheStatus {
+        std::string name;
+        DBCache::State state;
+        size_t keys;
+        long long warmupMs; /*!< -1 while not warm */
+    };
+
+    /**
+    *  \brief Warm-up state of all caches (connections with disabled cache are not listed)
+    **/
+    std::vector<CacheStatus> getCacheStatus();
+
 #define DBM_CREATION_HELPER(...) __VA_ARGS__
-#define CREATE_DBM_FUNCTION(fncname, fncargtypes, fncargs) \
+#define CREATE_DBM_FUNCTION_WITH_HOOK(fncname, fncargtypes, fncargs, hook) \
     template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::ASYNC_FUTURE, std::shared_future<DBReturn> >\
     fncname(const std::string& workerName, fncargtypes) {\
         auto worker = this->__getDbWorker(workerName);\
+        hook;\
         return worker->fncname< DBExecutionType::ASYNC_FUTURE >(fncargs);\
     };\
     template <DBExecutionType T>\
@@ -53,15 +158,27 @@ public:
         std::optional<DBCallbackArg>&& args\
     ) {\
         auto worker = this->__getDbWorker(workerName);\
+        hook;\
         return worker->fncname< DBExecutionType::ASYNC_CALLBACK >(fncargs, std::move(fnc), std::move(args));\
     };\
     template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_POLL, DBTicket>\
+    fncname(const std::string& workerName, fncargtypes) {\
+        auto worker = this->__getDbWorker(workerName);\
+        hook;\
+        return worker->fncname< DBExecutionType::ASYNC_POLL >(fncargs);\
+    };\
+    template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::SYNC, DBReturn>\
     fncname(const std::string& workerName, fncargtypes) {\
         auto worker = this->__getDbWorker(workerName);\
+        hook;\
         return worker->fncname< DBExecutionType::SYNC >(fncargs);\
     };
 
+#define CREATE_DBM_FUNCTION(fncname, fncargtypes, fncargs) \
+    CREATE_DBM_FUNCTION_WITH_HOOK(fncname, DBM_CREATION_HELPER(fncargtypes), DBM_CREATION_HELPER(fncargs), )
+
 #define CREATE_DBM_FUNCTION_NO_ARGS(fncname) \
     template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::ASYNC_FUTURE, std::shared_future<DBReturn> >\
@@ -79,6 +196,12 @@ public:
         return worker->fncname< DBExecutionType::ASYNC_CALLBACK >(std::move(fnc), std::move(args));\
     };\
     template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_POLL, DBTicket>\
+    fncname(const std::string& workerName) {\
+        auto worker = this->__getDbWorker(workerName);\
+        return worker->fncname< DBExecutionType::ASYNC_POLL >();\
+    };\
+    template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::SYNC, DBReturn>\
     fncname(const std::string& workerName) {\
         auto worker = this->__getDbWorker(workerName);\
@@ -93,13 +216,24 @@ public:
 
     CREATE_DBM_FUNCTION(keys, std::string&& prefix, std::move(prefix));
 
+    /**
+    *  \brief DB key listing in pages, see DBConnector::scanKeys  Args are moved!
+    *
+    *  \param prefix const std::string&
+    *  \param cursor const std::string& "" for the first page
+    *  \param count size_t keys per page
+    **/
+
+    CREATE_DBM_FUNCTION(scanKeys, DBM_CREATION_HELPER(std::string&& prefix, std::string&& cursor, size_t count), DBM_CREATION_HELPER(std::move(prefix), std::move(cursor), count));
+
     /**
     *  \brief DB GET  Args are moved!
     *
     *  \param key const std::string&
     **/
 
-    CREATE_DBM_FUNCTION(get, std::string&& key, std::move(key));
+    CREATE_DBM_FUNCTION_WITH_HOOK(get, std::string&& key, std::move(key),
+        this->__onRead(workerName, key));
 
     /**
     *  \brief DB GETRANGE  Args are moved!
@@ -109,21 +243,24 @@ public:
     *  \param to unsigned int
     *
     **/
-    CREATE_DBM_FUNCTION(getRange, DBM_CREATION_HELPER(std::string&& key, unsigned int from, unsigned int to), DBM_CREATION_HELPER(std::move(key),from,to));
+    CREATE_DBM_FUNCTION_WITH_HOOK(getRange, DBM_CREATION_HELPER(std::string&& key, unsigned int from, unsigned int to), DBM_CREATION_HELPER(std::move(key),from,to),
+        this->__onRead(workerName, key));
 
     /**
     *  \brief DB GETTTL  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_DBM_FUNCTION(getWithTtl, std::string&& key, std::move(key));
+    CREATE_DBM_FUNCTION_WITH_HOOK(getWithTtl, std::string&& key, std::move(key),
+        this->__onRead(workerName, key));
 
     /**
     *  \brief DB EXISTS  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_DBM_FUNCTION(exists, std::string&& key, std::move(key));
+    CREATE_DBM_FUNCTION_WITH_HOOK(exists, std::string&& key, std::move(key),
+        this->__onRead(workerName, key));
 
     /**
     *  \brief DB SET  Args are moved!
@@ -131,7 +268,8 @@ public:
     *  \param key const std::string&
     *  \param value const std::string&
     **/
-    CREATE_DBM_FUNCTION(set, DBM_CREATION_HELPER(std::string&& key, std::string&& value), DBM_CREATION_HELPER(std::move(key), std::move(value)));
+    CREATE_DBM_FUNCTION_WITH_HOOK(set, DBM_CREATION_HELPER(std::string&& key, std::string&& value), DBM_CREATION_HELPER(std::move(key), std::move(value)),
+        this->__onSet(workerName, key, value, -1));
 
     /**
     *  \brief DB SETEX  Args are moved!
@@ -140,7 +278,24 @@ public:
     *  \param ttl int
     *  \param value const std::string&
     **/
-    CREATE_DBM_FUNCTION(setEx, DBM_CREATION_HELPER(std::string&& key, int ttl, std::string&& value), DBM_CREATION_HELPER(std::move(key),ttl,std::move(value)));
+    CREATE_DBM_FUNCTION_WITH_HOOK(setEx, DBM_CREATION_HELPER(std::string&& key, int ttl, std::string&& value), DBM_CREATION_HELPER(std::move(key),ttl,std::move(value)),
+        this->__onSet(workerName, key, value, ttl));
+
+    /**
+    *  \brief DB multi SET in one transaction  Args are moved!
+    *
+    *  \param entries const std::vector<DBKeyValue>&
+    **/
+    CREATE_DBM_FUNCTION_WITH_HOOK(setMany, std::vector<DBKeyValue>&& entries, std::move(entries),
+        this->__onSetMany(workerName, entries));
+
+    /**
+    *  \brief DB multi SETEX in one transaction  Args are moved!
+    *
+    *  \param entries const std::vector<DBKeyEntry>& ttl < 0 does not expire
+    **/
+    CREATE_DBM_FUNCTION_WITH_HOOK(setExMany, std::vector<DBKeyEntry>&& entries, std::move(entries),
+        this->__onSetMany(workerName, entries));
 
 
     /**
@@ -150,21 +305,24 @@ public:
     *  \param value const std::string&
     *  \param ttl int
     **/
-    CREATE_DBM_FUNCTION(expire, DBM_CREATION_HELPER(std::string&& key, int ttl), DBM_CREATION_HELPER(std::move(key),ttl));
+    CREATE_DBM_FUNCTION_WITH_HOOK(expire, DBM_CREATION_HELPER(std::string&& key, int ttl), DBM_CREATION_HELPER(std::move(key),ttl),
+        this->__onExpire(workerName, key, ttl));
 
     /**
     *  \brief DB DEL  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_DBM_FUNCTION(del, std::string&& key, std::move(key));
+    CREATE_DBM_FUNCTION_WITH_HOOK(del, std::string&& key, std::move(key),
+        this->__onDel(workerName, key));
 
     /**
     *  \brief DB TTL  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_DBM_FUNCTION(ttl, std::string&& key, std::move(key));
+    CREATE_DBM_FUNCTION_WITH_HOOK(ttl, std::string&& key, std::move(key),
+        this->__onRead(workerName, key));
 
     /**
     *  \brief DB PING
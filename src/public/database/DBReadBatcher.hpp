@@ -0,0 +1,98 @@
+#pragma once
+
+#ifndef __DB_READ_BATCHER_HPP__
+#define __DB_READ_BATCHER_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <atomic>
+
+#include <threading/Executor.hpp>
+
+/**
+*   \brief Collects independent reads of one connection into multi key fetches
+*
+*   The first read opens a batch and queues one task for it on the executor.
+*   Reads that arrive until the task runs, or until window has passed since the batch was opened,
+*   join the batch, a batch that reaches maxBatch keys is closed at once.
+*   The task fetches all keys with one getMany (MGET / WHERE key IN (...)) and hands every read its value.
+*
+*   Under low load a read is issued on its own after at most window, under load many queued reads
+*   share one round trip.
+**/
+class DBReadBatcher {
+public:
+
+    /**
+    *  \brief Receives the value of one read ("" if the key does not exist), failed if the fetch threw
+    **/
+    typedef std::function<void(std::string&& value, bool failed)> Completion;
+
+    /**
+    *  \brief Fetches the values of all keys in their order (runs on the executor)
+    **/
+    typedef std::function<std::vector<std::string>(const std::vector<std::string>& keys)> Fetch;
+
+    struct Stats {
+        uint64_t batches;   /*!< fetches issued */
+        uint64_t reads;     /*!< reads that went through the batcher */
+        uint64_t maxBatch;  /*!< most keys in one fetch */
+    };
+
+private:
+
+    struct PendingRead {
+        std::string key;
+        Completion done;
+    };
+
+    struct Batch {
+        std::vector<PendingRead> reads;
+        std::chrono::steady_clock::time_point openedAt;
+    };
+
+    Executor& executor;
+    Fetch fetch;
+    std::chrono::microseconds window;
+    size_t maxBatch;
+
+    std::mutex mutex;
+    std::condition_variable closed;
+    std::shared_ptr<Batch> open; /*!< batch new reads join, nullptr if none */
+
+    std::atomic<uint64_t> batches = 0;
+    std::atomic<uint64_t> reads = 0;
+    std::atomic<uint64_t> maxBatchSeen = 0;
+
+    /**
+    *  \brief Waits for the window of the batch, closes it and fetches its keys (executor thread)
+    **/
+    void __run(const std::shared_ptr<Batch>& batch);
+
+public:
+
+    DBReadBatcher(Executor& executor, Fetch&& fetch, std::chrono::microseconds window, size_t maxBatch);
+
+    DBReadBatcher() = delete;
+    DBReadBatcher(const DBReadBatcher&) = delete;
+    DBReadBatcher& operator=(const DBReadBatcher&) = delete;
+    DBReadBatcher(DBReadBatcher&&) = delete;
+    DBReadBatcher& operator=(DBReadBatcher&&) = delete;
+
+    /**
+    *  \brief Adds a read to the open batch or opens a new one
+    *
+    *  \param priority priority of the task of a new batch
+    *  \throws std::runtime_error if the executor rejected the task of a new batch, done is not called then
+    **/
+    void add(std::string&& key, Completion&& done, Executor::Priority priority);
+
+    Stats getStats() const;
+};
+
+#endif // __DB_READ_BATCHER_HPP__
@@ -12,12 +12,18 @@
 #include <optional>
 #include <mutex>
 #include <shared_mutex>
+#include <atomic>
+#include <future>
+#include <map>
+#include <unordered_map>
+#include <condition_variable>
 
 #include <database/DBConfig.hpp>
 #include <database/DBConnector.hpp>
-#include <database/MySQLConnector.hpp>
-#include <database/RedisConnector.hpp>
-#include <database/SQLiteConnector.hpp>
+#include <database/DBConnectionPool.hpp>
+#include <database/DBCache.hpp>
+#include <database/DBReadBatcher.hpp>
+#include <threading/Executor.hpp>
 
 #include <main.hpp>
 
@@ -41,7 +47,8 @@ typedef std::variant<
     bool,           // success/failure
     int,            // ttl
     std::pair<std::string, int>, // value, ttl
-    std::vector<std::string> // keys
+    std::vector<std::string>, // keys
+    DBKeyPage // next cursor, keys
 > DBReturn;
 
 /**
@@ -66,7 +73,10 @@ typedef std::variant<
 #endif
 > DBCallbackArg;
 
-typedef std::shared_ptr<DBConnector> DBConRef;
+/**
+* Id of a ASYNC_POLL request, see EpochServer::reserveTicket
+**/
+typedef unsigned int DBTicket;
 
 /**
 * Statement execution type
@@ -77,6 +87,7 @@ typedef std::shared_ptr<DBConnector> DBConRef;
 enum class DBExecutionType {
     ASYNC_CALLBACK,
     ASYNC_FUTURE,
+    ASYNC_POLL,
     SYNC
 };
 
@@ -87,17 +98,40 @@ enum class DBExecutionType {
 class DBWorker {
 private:
 
+    /*!< async calls go out through the async connector calls instead of the executor (redisAsync) */
+    bool asyncConnector = false;
+
+    /*!< counters of the async connector calls, see AsyncStats */
+    std::atomic<uint64_t> asyncCalls = 0;
+    std::atomic<uint64_t> asyncCompleted = 0;
+    std::atomic<uint64_t> asyncFailed = 0;
+    std::atomic<uint64_t> asyncRejected = 0;
+    std::atomic<uint64_t> asyncInFlight = 0;
+    std::atomic<uint64_t> asyncMaxInFlight = 0;
+    std::atomic<uint64_t> asyncMicros = 0;
+    std::atomic<uint64_t> asyncMaxMicros = 0;
+    std::atomic<uint64_t> asyncTimedOut = 0;
+
     /**
-    * \brief Worker connections
-    *
-    * Now this is a bit ugly, but its the easiest way
-    *
+    *  Async calls waiting for their reply by id (ids increase with the send time, so do the deadlines),
+    *  expireAsyncCalls completes the overdue ones as failed.
     **/
+    struct PendingAsync {
+        utils::timestamp deadline;
+        std::function<void(DBReturn&& result, bool failed)> done;
+    };
+    std::mutex asyncMutex;
+    std::map<uint64_t, PendingAsync> asyncPending;
+    uint64_t asyncNextId = 0;
 
-    /*!< pointers to the db connectors */
-    std::vector<std::pair<std::thread::id, DBConRef > > dbConnectors;
-    std::atomic<unsigned int> dbConnectorUID = 0;
-    size_t dbConnectorsCount = 0;
+    /*!< connections of this worker, any thread checks one out per call */
+    std::unique_ptr<DBConnectionPool> connections;
+
+    /*!< collects async gets into multi key fetches, nullptr if disabled */
+    std::unique_ptr<DBReadBatcher> readBatcher;
+
+    /*!< runs the async calls of this worker, declared after connections and readBatcher so it is stopped first */
+    std::unique_ptr<Executor> executor;
 
     /**
     * Settings
@@ -109,6 +143,155 @@ private:
     /*!< database connection details */
     DBConfig dbConfig;
 
+    /*!< read cache of this connection, keys the database did not find are reported to it */
+    std::shared_ptr<DBCache> cache = nullptr;
+
+    /**
+      *   \brief Writes of one key that were issued and are not completed yet
+      **/
+    struct KeyWrites {
+        uint64_t issued = 0;
+        uint64_t done = 0;
+        Executor::Priority lane = Executor::Priority::HIGH; /*!< lowest lane of the writes */
+    };
+    typedef std::shared_ptr<KeyWrites> KeyWritesRef;
+
+    std::mutex keyWritesMutex;
+    std::condition_variable keyWritesCv;
+    std::unordered_map<std::string, KeyWritesRef> keyWrites;
+
+    void __beginWrites(const std::vector<std::string>& keys, Executor::Priority lane);
+    void __endWrites(const std::vector<std::string>& keys);
+    bool __hasPendingWrites(const std::string& key);
+
+    /**
+      *   \brief State of a read taken when it is issued
+      **/
+    struct ReadStart {
+        uint64_t token;             /*!< see __onNotFound */
+        KeyWritesRef writes;        /*!< writes of the key issued before the read, nullptr if there were none */
+        uint64_t after;             /*!< the read may run once writes->done reached this */
+    };
+
+    /**
+      *   \brief Orders a read (or a single key write) after the writes of its key that were issued before it
+      *
+      *   The call goes to the lane of the pending writes (if that is lower than its own), the lanes are FIFO so it is taken after them.
+      *   __awaitWrites then lets it wait until they are done, another executor thread may still be running them.
+      *   A write takes it before its WriteGuard, so it only waits for the writes before it.
+      **/
+    ReadStart __beginRead(const std::string& key, Executor::Priority& priority);
+    void __awaitWrites(const ReadStart& read);
+
+    /**
+      *   \brief Connection call of a read that waits for the writes of its key first, see __afterWrites
+      **/
+    template<typename F>
+    struct ReadCall {
+        ReadStart read;
+        F fnc;
+    };
+
+    /**
+      *   \brief Makes fnc wait for the writes issued before the read, before it checks out a connection
+      *
+      *   A waiting read must not hold a connection, the write it waits for may need it (pool max below the thread count).
+      **/
+    template<typename F>
+    static ReadCall<std::decay_t<F>> __afterWrites(const ReadStart& read, F&& fnc) {
+        return ReadCall<std::decay_t<F>>{ read, std::forward<F>(fnc) };
+    }
+
+    /**
+      *   \brief Negative caching of read results, see DBCache::noteAbsent
+      *
+      *   The token is taken when the read is issued, the result is reported from the pool thread.
+      *   While a write of the key is pending the result is not remembered, the write may land right after it.
+      **/
+    uint64_t __readToken(const std::string& key) {
+        return this->cache ? this->cache->readToken(key) : 0;
+    }
+    void __onNotFound(const std::string& key, uint64_t token) {
+        if (this->cache && !this->__hasPendingWrites(key)) {
+            this->cache->noteAbsent(key, token);
+        }
+    }
+
+    /**
+      *   \brief Keeps the write-through of a write only if the database applied it
+      *
+      *   DBManager updates the cache before the call is issued. The guard is created by the call (prepare) and
+      *   shared by its lambdas: a call that returned false, threw or was never run (full queue, in-flight limit)
+      *   invalidates its keys, when it completes or when the last lambda holding the guard is destroyed.
+      *   false of expire / del can also mean "no such key", invalidating it is harmless.
+      *   The keys count as pending writes of the worker from its creation until it is completed (see __beginRead).
+      **/
+    class WriteGuard {
+    private:
+        DBWorker* worker;
+        std::vector<std::string> keys;
+        std::atomic<bool> completed = false;
+
+    public:
+        WriteGuard(DBWorker* worker, std::vector<std::string>&& keys, Executor::Priority lane) : worker(worker), keys(std::move(keys)) {
+            this->worker->__beginWrites(this->keys, lane);
+        };
+        ~WriteGuard() { this->complete(false); };
+
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator=(const WriteGuard&) = delete;
+
+        /**
+          *   \param applied the database holds the written state
+          **/
+        void complete(bool applied) {
+            if (this->completed.exchange(true)) return;
+            if (auto& cache = this->worker->cache) {
+                for (auto& key : this->keys) {
+                    if (applied) {
+                        cache->writeDone(key);
+                    }
+                    else {
+                        cache->invalidate(key);
+                    }
+                }
+            }
+            this->worker->__endWrites(this->keys);
+        };
+
+        /**
+          *   \brief Runs the connector call of the executor path
+          **/
+        template<typename F>
+        bool run(F&& call) {
+            bool applied = false;
+            try {
+                applied = call();
+            }
+            catch (...) {
+                this->complete(false);
+                throw;
+            }
+            this->complete(applied);
+            return applied;
+        };
+    };
+    typedef std::shared_ptr<WriteGuard> WriteGuardRef;
+
+    WriteGuardRef __writeGuard(std::vector<std::string>&& keys, Executor::Priority lane) {
+        return std::make_shared<WriteGuard>(this, std::move(keys), lane);
+    }
+
+    template<typename E>
+    WriteGuardRef __writeGuard(const std::vector<E>& entries, Executor::Priority lane) {
+        std::vector<std::string> keys;
+        keys.reserve(entries.size());
+        for (auto& entry : entries) {
+            keys.emplace_back(entry.first);
+        }
+        return this->__writeGuard(std::move(keys), lane);
+    }
+
     /**
       *   \brief Internal method for handling callbacks
       *
@@ -125,22 +308,102 @@ private:
     );
 
     /**
-      *   \brief Internal function for lockless db connector assignment
+      *   \brief Runs a call on a pooled connection
+      *
+      *   A connection whose call threw is health checked before it is reused.
       *
-      *   \throws std::runtime_exception if all connectors are assigned and anew one is requested
+      *   \throws std::runtime_error if no connection is available, rethrows errors of the call
       **/
-    DBConRef getConnector();
+    DBReturn __runOnConnection(const std::function<DBReturn(const DBConRef& ref)>& fnc);
 
-    template<typename E>
+    /**
+      *   \brief Runs a call of the executor path, a ReadCall waits for its writes before the connection is checked out
+      **/
+    template<typename F>
+    DBReturn __runCall(const F& fnc) {
+        return this->__runOnConnection(fnc);
+    }
+
+    template<typename F>
+    DBReturn __runCall(const ReadCall<F>& call) {
+        this->__awaitWrites(call.read);
+        return this->__runOnConnection(call.fnc);
+    }
+
+    /**
+      *   \brief Receives the result of an async connector call, failed if it could not be sent
+      **/
+    typedef std::function<void(DBReturn&& result, bool failed)> AsyncDone;
+
+    /**
+      *   \brief Sends a call with the async connector calls, done runs when the reply arrives
+      *
+      *   No executor thread is involved, done runs on the network thread of the connector
+      *   (or on the calling thread if the call could not be sent, or the expiry tick if there was no reply
+      *   within redisReplyTimeoutMs) and is called exactly once.
+      *   The connection is taken without connecting, the game thread does not wait for a reconnect.
+      *
+      *   \throws std::runtime_error if redisAsyncMaxInFlight calls are in flight, done is not called then
+      **/
+    void __runAsync(const std::function<void(const DBConRef& ref, AsyncDone&& done)>& fnc, AsyncDone&& done);
+
+    /**
+      *   \brief Completion of a connector call that forwards the result as DBReturn
+      **/
+    template<typename R>
+    static DBCompletion<R> __forward(AsyncDone&& done) {
+        return [done = std::move(done)](R&& result, bool failed) {
+            done(DBReturn(std::move(result)), failed);
+        };
+    }
+
+    /**
+      *   \brief Completion of a connector write that completes its guard before the result is forwarded
+      **/
+    static DBCompletion<bool> __forwardWrite(const WriteGuardRef& guard, AsyncDone&& done) {
+        return [guard, done = std::move(done)](bool&& applied, bool failed) {
+            guard->complete(!failed && applied);
+            done(DBReturn(applied), failed);
+        };
+    }
+
+    static void __recordMax(std::atomic<uint64_t>& max, uint64_t value) {
+        uint64_t current = max.load();
+        while (value > current && !max.compare_exchange_weak(current, value)) {}
+    }
+
+    /**
+      *   \brief Queues a get on the read batcher, reports "not found" to the cache like a direct get
+      *
+      *   \throws std::runtime_error if the executor queue is full
+      **/
+    void __batchGet(std::string&& key, std::function<void(const DBReturn& result, bool failed)>&& done);
+
+    /*!< priority of the calls issued by this thread, set by PriorityScope */
+    static thread_local std::optional<Executor::Priority> priorityOverride;
+
+    /**
+      *   \brief Priority of a call: the one of the current PriorityScope, the default of the function otherwise
+      **/
+    static Executor::Priority __callPriority(Executor::Priority defaultPriority) {
+        return priorityOverride.value_or(defaultPriority);
+    }
+
+    /**
+      *   \brief Ticket handling for ASYNC_POLL (forwarded to the server's ticket table)
+      **/
+    static DBTicket reserveTicket();
+    static void fulfillTicket(DBTicket ticket, const DBReturn& result);
+    static void cancelTicket(DBTicket ticket);
+
+    template<typename E, typename F>
     inline std::function<DBReturn()> getFncWrapper(
         E&& errorValue,
-        std::function<DBReturn(const DBConRef& ref)>&& f
+        F&& f
     ) {
-        return [this, errorValue = std::move(errorValue), fnc = std::move(f)](){
+        return [this, errorValue = std::move(errorValue), fnc = std::forward<F>(f)](){
             try {
-                auto& db = this->getConnector();
-                DBReturn result = fnc(db);
-                return result;
+                return this->__runCall(fnc);
             }
             catch (std::exception& e) {
                 return static_cast<DBReturn>(errorValue);
@@ -148,27 +411,81 @@ private:
         };
     }
 
-    template<typename E>
+    template<typename E, typename F>
     inline std::function<void()> getFncWrapper(
         E&& errorValue,
-        std::function<DBReturn(const DBConRef& ref)>&& fnc,
+        F&& fnc,
         std::optional<DBCallback>&& callback,
         std::optional<DBCallbackArg>&& args
     ) {
-        return [this, errorValue = std::move(errorValue), fnc = std::move(fnc),
+        return [this, errorValue = std::move(errorValue), fnc = std::forward<F>(fnc),
             callback = std::move(callback), args = std::move(args)
         ](){
             try {
-                auto& db = this->getConnector();
-                DBReturn result = fnc(db);
+                DBReturn result = this->__runCall(fnc);
                 this->callbackResultIfNeeded(result, callback, args);
             }
             catch (std::exception& e) {}
         };
     }
 
+    template<typename E, typename F>
+    inline std::function<void()> getFncWrapper(
+        E&& errorValue,
+        F&& f,
+        DBTicket ticket
+    ) {
+        return [this, errorValue = std::move(errorValue), fnc = std::forward<F>(f), ticket](){
+            // the ticket has to be fulfilled in any case, otherwise the slot is never freed
+            DBReturn result;
+            try {
+                result = this->__runCall(fnc);
+            }
+            catch (std::exception& e) {
+                result = static_cast<DBReturn>(errorValue);
+            }
+            fulfillTicket(ticket, result);
+        };
+    }
+
 public:
 
+    /**
+      *   \brief Overrides the priority of all calls the current thread issues while it exists
+      *
+      *   Reads (get, getTtl, exists, ...) are HIGH, writes (single and multi key) are NORMAL and key listings are LOW by default.
+      *   SQF can choose the priority per call ("dbGet:low", see EpochServer::callExtensionEntrypoint).
+      **/
+    class PriorityScope {
+    private:
+        std::optional<Executor::Priority> previous;
+    public:
+        PriorityScope(Executor::Priority priority) : previous(priorityOverride) { priorityOverride = priority; };
+        ~PriorityScope() { priorityOverride = this->previous; };
+
+        PriorityScope(const PriorityScope&) = delete;
+        PriorityScope& operator=(const PriorityScope&) = delete;
+        PriorityScope(PriorityScope&&) = delete;
+        PriorityScope& operator=(PriorityScope&&) = delete;
+    };
+
+    struct AsyncStats {
+        uint64_t calls;         /*!< async connector calls sent */
+        uint64_t completed;     /*!< calls whose reply arrived (or that failed) */
+        uint64_t failed;        /*!< calls that could not be sent */
+        uint64_t rejected;      /*!< calls rejected because of redisAsyncMaxInFlight */
+        uint64_t inFlight;      /*!< calls waiting for their reply */
+        uint64_t maxInFlight;
+        uint64_t micros;        /*!< total time from sending to the reply */
+        uint64_t maxMicros;
+        uint64_t timedOut;      /*!< calls failed because their reply did not arrive in time */
+    };
+
+    /**
+      *   \brief Appends the result as SQF value to out (strings are quoted)
+      **/
+    static void formatResult(const DBReturn& result, std::string& out);
+
     /**
     *  \brief Constructor
     *
@@ -188,12 +505,21 @@ public:
     ~DBWorker();
 
 
-#define CREATE_FUNCTION(fncname, defaultreturn, lambda, ...) \
+/**
+*  Generates the ASYNC_FUTURE, ASYNC_CALLBACK, ASYNC_POLL and SYNC variant of a call.
+*  prepare runs first in every variant, before the lambdas take the arguments: the lambdas can capture the locals
+*  it declares (no init-capture that depends on another one), it may change callPriority. NO_PREPARE if there is nothing to do.
+**/
+#define NO_PREPARE
+#define CREATE_FUNCTION(fncname, defaultreturn, priority, prepare, lambda, ...) \
     template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::ASYNC_FUTURE, std::shared_future<DBReturn> >\
     fncname(__VA_ARGS__) {\
-        return threadpool->enqueue(\
-            this->getFncWrapper(defaultreturn, lambda);\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        return this->executor->enqueue(\
+            this->getFncWrapper(defaultreturn, lambda),\
+            callPriority\
         ).share();\
     };\
     template <DBExecutionType T>\
@@ -202,23 +528,49 @@ public:
         std::optional<DBCallback>&& fnc,\
         std::optional<DBCallbackArg>&& args\
     ) {\
-        threadpool->fireAndForget(\
-            this->getFncWrapper(defaultreturn, lambda, std::move(fnc), std::move(args))\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        this->executor->fireAndForget(\
+            this->getFncWrapper(defaultreturn, lambda, std::move(fnc), std::move(args)),\
+            callPriority\
         );\
     };\
     template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_POLL, DBTicket >\
+    fncname(__VA_ARGS__) {\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        DBTicket ticket = reserveTicket();\
+        try {\
+            this->executor->fireAndForget(\
+                this->getFncWrapper(defaultreturn, lambda, ticket),\
+                callPriority\
+            );\
+        }\
+        catch (...) {\
+            /* rejected, the call never runs and its slot is free again at once */\
+            cancelTicket(ticket);\
+            throw;\
+        }\
+        return ticket;\
+    };\
+    template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::SYNC, DBReturn >\
     fncname(__VA_ARGS__) {\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        static_cast<void>(callPriority);\
         return (this->getFncWrapper(defaultreturn, lambda))();\
     };
 
 // TODO find a alternative to __VA_OPT__(,) and merge this into CREATE_FUNCTION
-#define CREATE_FUNCTION_NO_ARGS(fncname, defaultreturn, lambda) \
+#define CREATE_FUNCTION_NO_ARGS(fncname, defaultreturn, priority, lambda) \
     template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::ASYNC_FUTURE, std::shared_future<DBReturn> >\
     fncname() {\
-        return threadpool->enqueue(\
-            this->getFncWrapper(defaultreturn, lambda);\
+        return this->executor->enqueue(\
+            this->getFncWrapper(defaultreturn, lambda),\
+            __callPriority(Executor::Priority::priority)\
         ).share();\
     };\
     template <DBExecutionType T>\
@@ -227,31 +579,213 @@ public:
         std::optional<DBCallback>&& fnc,\
         std::optional<DBCallbackArg>&& args\
     ) {\
-        threadpool->enqueue(\
-            this->getFncWrapper(defaultreturn, lambda, std::move(fnc), std::move(args))\
+        this->executor->enqueue(\
+            this->getFncWrapper(defaultreturn, lambda, std::move(fnc), std::move(args)),\
+            __callPriority(Executor::Priority::priority)\
         );\
     };\
     template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_POLL, DBTicket >\
+    fncname() {\
+        DBTicket ticket = reserveTicket();\
+        try {\
+            this->executor->fireAndForget(\
+                this->getFncWrapper(defaultreturn, lambda, ticket),\
+                __callPriority(Executor::Priority::priority)\
+            );\
+        }\
+        catch (...) {\
+            /* rejected, the call never runs and its slot is free again at once */\
+            cancelTicket(ticket);\
+            throw;\
+        }\
+        return ticket;\
+    };\
+    template <DBExecutionType T>\
     inline std::enable_if_t<T == DBExecutionType::SYNC, DBReturn >\
     fncname() {\
         return (this->getFncWrapper(defaultreturn, lambda))();\
     };
 
+/**
+*  Like CREATE_FUNCTION, with asynclambda (const DBConRef& ref, AsyncDone&& done) as the async path of async connectors:
+*  ASYNC calls send the command at once and are completed by its reply, priority only applies to the executor path.
+*  prepare has to declare the ReadStart read of the key (__beginRead): while writes of the key are pending
+*  the call takes the executor path and waits for them (lambda wrapped with __afterWrites), instead of overtaking
+*  a write that was not sent yet.
+**/
+#define CREATE_ASYNC_FUNCTION(fncname, defaultreturn, priority, prepare, lambda, asynclambda, ...) \
+    template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_FUTURE, std::shared_future<DBReturn> >\
+    fncname(__VA_ARGS__) {\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        if (!this->asyncConnector || read.writes) {\
+            return this->executor->enqueue(\
+                this->getFncWrapper(defaultreturn, lambda),\
+                callPriority\
+            ).share();\
+        }\
+        auto promise = std::make_shared<std::promise<DBReturn>>();\
+        auto result = promise->get_future().share();\
+        this->__runAsync(asynclambda, [promise](DBReturn&& value, bool failed) {\
+            promise->set_value(failed ? static_cast<DBReturn>(defaultreturn) : std::move(value));\
+        });\
+        return result;\
+    };\
+    template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_CALLBACK, void >\
+    fncname(__VA_ARGS__,\
+        std::optional<DBCallback>&& fnc,\
+        std::optional<DBCallbackArg>&& args\
+    ) {\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        if (!this->asyncConnector || read.writes) {\
+            this->executor->fireAndForget(\
+                this->getFncWrapper(defaultreturn, lambda, std::move(fnc), std::move(args)),\
+                callPriority\
+            );\
+            return;\
+        }\
+        /* like the executor path, a failed call has no callback */\
+        this->__runAsync(asynclambda, [this, fnc = std::move(fnc), args = std::move(args)](DBReturn&& value, bool failed) {\
+            if (!failed) {\
+                this->callbackResultIfNeeded(value, fnc, args);\
+            }\
+        });\
+    };\
+    template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_POLL, DBTicket >\
+    fncname(__VA_ARGS__) {\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        DBTicket ticket = reserveTicket();\
+        try {\
+            if (!this->asyncConnector || read.writes) {\
+                this->executor->fireAndForget(\
+                    this->getFncWrapper(defaultreturn, lambda, ticket),\
+                    callPriority\
+                );\
+            }\
+            else {\
+                this->__runAsync(asynclambda, [ticket](DBReturn&& value, bool failed) {\
+                    fulfillTicket(ticket, failed ? static_cast<DBReturn>(defaultreturn) : value);\
+                });\
+            }\
+        }\
+        catch (...) {\
+            /* rejected, the call never runs and its slot is free again at once */\
+            cancelTicket(ticket);\
+            throw;\
+        }\
+        return ticket;\
+    };\
+    template <DBExecutionType T>\
+    inline std::enable_if_t<T == DBExecutionType::SYNC, DBReturn >\
+    fncname(__VA_ARGS__) {\
+        Executor::Priority callPriority = __callPriority(Executor::Priority::priority);\
+        prepare;\
+        static_cast<void>(callPriority);\
+        return (this->getFncWrapper(defaultreturn, lambda))();\
+    };
+
     /**
     *  \brief DB Key  Args are moved!
     *
     *  \param pattern const std::string&
     **/
 
-    CREATE_FUNCTION(keys, std::vector<std::string>(), [prefix = std::move(prefix)](const DBConRef& ref){ return DBReturn(ref->keys(prefix)); }, std::string&& prefix);
+    CREATE_FUNCTION(keys, std::vector<std::string>(), LOW, NO_PREPARE, [prefix = std::move(prefix)](const DBConRef& ref){ return DBReturn(ref->keys(prefix)); }, std::string&& prefix);
+
+    /**
+    *  \brief DB key listing in pages, see DBConnector::scanKeys  Args are moved!
+    *
+    *  Returns false instead of a page if the listing failed, an empty last page would look like the end of the listing.
+    *
+    *  \param prefix const std::string&
+    *  \param cursor const std::string& "" for the first page
+    *  \param count size_t keys per page
+    **/
+
+    CREATE_FUNCTION(scanKeys, false, LOW, NO_PREPARE, ([prefix = std::move(prefix), cursor = std::move(cursor), count](const DBConRef& ref){
+        return DBReturn(ref->scanKeys(prefix, cursor, count));
+    }), std::string&& prefix, std::string&& cursor, size_t count);
+
+    /**
+    *  \brief DB GET of a single key without batching  Args are moved!
+    *
+    *  \param key const std::string&
+    **/
+
+    CREATE_ASYNC_FUNCTION(getDirect, "", HIGH, ReadStart read = this->__beginRead(key, callPriority), (__afterWrites(read, [this, token = read.token, key = std::move(key)](const DBConRef& ref){
+        auto value = ref->get(key);
+        if (value.empty()) this->__onNotFound(key, token);
+        return DBReturn(std::move(value));
+    })), ([this, token = read.token, key = std::move(key)](const DBConRef& ref, AsyncDone&& done){
+        ref->getAsync(key, [this, token, key, done = std::move(done)](std::string&& value, bool failed) {
+            if (!failed && value.empty()) this->__onNotFound(key, token);
+            done(DBReturn(std::move(value)), failed);
+        });
+    }), std::string&& key);
 
     /**
     *  \brief DB GET  Args are moved!
     *
+    *  Async gets go through the read batcher if it is enabled (readBatch config) and no write of the key is pending,
+    *  SYNC gets are always direct.
+    *
     *  \param key const std::string&
     **/
+    template <DBExecutionType T>
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_FUTURE, std::shared_future<DBReturn> >
+    get(std::string&& key) {
+        if (!this->readBatcher || this->__hasPendingWrites(key)) return this->getDirect<T>(std::move(key));
+
+        auto promise = std::make_shared<std::promise<DBReturn>>();
+        auto result = promise->get_future().share();
+        this->__batchGet(std::move(key), [promise](const DBReturn& value, bool failed) {
+            promise->set_value(failed ? DBReturn(std::string()) : value);
+        });
+        return result;
+    };
+    template <DBExecutionType T>
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_CALLBACK, void >
+    get(std::string&& key,
+        std::optional<DBCallback>&& fnc,
+        std::optional<DBCallbackArg>&& args
+    ) {
+        if (!this->readBatcher || this->__hasPendingWrites(key)) return this->getDirect<T>(std::move(key), std::move(fnc), std::move(args));
 
-    CREATE_FUNCTION(get, "", [key = std::move(key)](const DBConRef& ref){ return ref->get(key); }, std::string&& key);
+        // like the direct call, a failed call has no callback
+        this->__batchGet(std::move(key), [this, fnc = std::move(fnc), args = std::move(args)](const DBReturn& value, bool failed) {
+            if (!failed) {
+                this->callbackResultIfNeeded(value, fnc, args);
+            }
+        });
+    };
+    template <DBExecutionType T>
+    inline std::enable_if_t<T == DBExecutionType::ASYNC_POLL, DBTicket >
+    get(std::string&& key) {
+        if (!this->readBatcher || this->__hasPendingWrites(key)) return this->getDirect<T>(std::move(key));
+
+        DBTicket ticket = reserveTicket();
+        try {
+            this->__batchGet(std::move(key), [ticket](const DBReturn& value, bool failed) {
+                fulfillTicket(ticket, failed ? DBReturn(std::string()) : value);
+            });
+        }
+        catch (...) {
+            cancelTicket(ticket);
+            throw;
+        }
+        return ticket;
+    };
+    template <DBExecutionType T>
+    inline std::enable_if_t<T == DBExecutionType::SYNC, DBReturn >
+    get(std::string&& key) {
+        return this->getDirect<T>(std::move(key));
+    };
 
     /**
     *  \brief DB GETRANGE  Args are moved!
@@ -261,21 +795,41 @@ public:
     *  \param to unsigned int
     *
     **/
-    CREATE_FUNCTION(getRange, "", ([key = std::move(key), from, to](const DBConRef& ref){ return ref->getRange(key,from,to); }), std::string&& key, unsigned int from, unsigned int to);
+    CREATE_FUNCTION(getRange, "", HIGH, ReadStart read = this->__beginRead(key, callPriority), (__afterWrites(read, [key = std::move(key), from, to](const DBConRef& ref){
+        return DBReturn(ref->getRange(key, from, to));
+    })), std::string&& key, unsigned int from, unsigned int to);
 
     /**
     *  \brief DB GETTTL  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_FUNCTION(getWithTtl, (std::pair<std::string, int>("", -1)), [key = std::move(key)](const DBConRef& ref){ return ref->getWithTtl(key); }, std::string&& key);
+    CREATE_ASYNC_FUNCTION(getWithTtl, (std::pair<std::string, int>("", -1)), HIGH, ReadStart read = this->__beginRead(key, callPriority), (__afterWrites(read, [this, token = read.token, key = std::move(key)](const DBConRef& ref){
+        auto value = ref->getWithTtl(key);
+        if (value.first.empty()) this->__onNotFound(key, token);
+        return DBReturn(std::move(value));
+    })), ([this, token = read.token, key = std::move(key)](const DBConRef& ref, AsyncDone&& done){
+        ref->getWithTtlAsync(key, [this, token, key, done = std::move(done)](std::pair<std::string, int>&& value, bool failed) {
+            if (!failed && value.first.empty()) this->__onNotFound(key, token);
+            done(DBReturn(std::move(value)), failed);
+        });
+    }), std::string&& key);
     
     /**
     *  \brief DB EXISTS  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_FUNCTION(exists, false, [key = std::move(key)](const DBConRef& ref){ return ref->exists(key); }, std::string&& key);
+    CREATE_ASYNC_FUNCTION(exists, false, HIGH, ReadStart read = this->__beginRead(key, callPriority), (__afterWrites(read, [this, token = read.token, key = std::move(key)](const DBConRef& ref){
+        bool found = ref->exists(key);
+        if (!found) this->__onNotFound(key, token);
+        return DBReturn(found);
+    })), ([this, token = read.token, key = std::move(key)](const DBConRef& ref, AsyncDone&& done){
+        ref->existsAsync(key, [this, token, key, done = std::move(done)](bool&& found, bool failed) {
+            if (!failed && !found) this->__onNotFound(key, token);
+            done(DBReturn(found), failed);
+        });
+    }), std::string&& key);
     
     /**
     *  \brief DB SET  Args are moved!
@@ -283,7 +837,10 @@ public:
     *  \param key const std::string&
     *  \param value const std::string&
     **/
-    CREATE_FUNCTION(set, false, ([key = std::move(key), value = std::move(value)](const DBConRef& ref){ return ref->set(key,value); }), std::string&& key, std::string&& value);
+    CREATE_ASYNC_FUNCTION(set, false, NORMAL, ReadStart read = this->__beginRead(key, callPriority); auto guard = this->__writeGuard({ key }, callPriority),
+        (__afterWrites(read, [guard, key = std::move(key), value = std::move(value)](const DBConRef& ref){ return guard->run([&]() { return ref->set(key, value); }); })),
+        ([guard, key = std::move(key), value = std::move(value)](const DBConRef& ref, AsyncDone&& done){ ref->setAsync(key, value, __forwardWrite(guard, std::move(done))); }),
+        std::string&& key, std::string&& value);
     
     /**
     *  \brief DB SETEX  Args are moved!
@@ -292,7 +849,28 @@ public:
     *  \param ttl int
     *  \param value const std::string&
     **/
-    CREATE_FUNCTION(setEx, false, ([key = std::move(key), value = std::move(value), ttl](const DBConRef& ref){ return ref->setEx(key, ttl, value); }), std::string&& key, int ttl, std::string&& value);
+    CREATE_ASYNC_FUNCTION(setEx, false, NORMAL, ReadStart read = this->__beginRead(key, callPriority); auto guard = this->__writeGuard({ key }, callPriority),
+        (__afterWrites(read, [guard, key = std::move(key), value = std::move(value), ttl](const DBConRef& ref){ return guard->run([&]() { return ref->setEx(key, ttl, value); }); })),
+        ([guard, key = std::move(key), value = std::move(value), ttl](const DBConRef& ref, AsyncDone&& done){ ref->setExAsync(key, ttl, value, __forwardWrite(guard, std::move(done))); }),
+        std::string&& key, int ttl, std::string&& value);
+    
+    /**
+    *  \brief DB multi SET in one transaction, see DBConnector::setMany  Args are moved!
+    *
+    *  \param entries const std::vector<DBKeyValue>&
+    **/
+    CREATE_FUNCTION(setMany, false, NORMAL, auto guard = this->__writeGuard(entries, callPriority),
+        ([guard, entries = std::move(entries)](const DBConRef& ref){ return DBReturn(guard->run([&]() { return ref->setMany(entries); })); }),
+        std::vector<DBKeyValue>&& entries);
+
+    /**
+    *  \brief DB multi SETEX in one transaction, see DBConnector::setExMany  Args are moved!
+    *
+    *  \param entries const std::vector<DBKeyEntry>& ttl < 0 does not expire
+    **/
+    CREATE_FUNCTION(setExMany, false, NORMAL, auto guard = this->__writeGuard(entries, callPriority),
+        ([guard, entries = std::move(entries)](const DBConRef& ref){ return DBReturn(guard->run([&]() { return ref->setExMany(entries); })); }),
+        std::vector<DBKeyEntry>&& entries);
     
 
     /**
@@ -302,28 +880,86 @@ public:
     *  \param value const std::string&
     *  \param ttl int
     **/
-    CREATE_FUNCTION(expire, false, ([key = std::move(key), ttl](const DBConRef& ref){ return ref->expire(key, ttl); }), std::string&& key, int ttl);
+    CREATE_ASYNC_FUNCTION(expire, false, NORMAL, ReadStart read = this->__beginRead(key, callPriority); auto guard = this->__writeGuard({ key }, callPriority),
+        (__afterWrites(read, [guard, key = std::move(key), ttl](const DBConRef& ref){ return guard->run([&]() { return ref->expire(key, ttl); }); })),
+        ([guard, key = std::move(key), ttl](const DBConRef& ref, AsyncDone&& done){ ref->expireAsync(key, ttl, __forwardWrite(guard, std::move(done))); }),
+        std::string&& key, int ttl);
     
     /**
     *  \brief DB DEL  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_FUNCTION(del, false, ([key = std::move(key)](const DBConRef& ref){ return ref->del(key); }), std::string&& key);
+    CREATE_ASYNC_FUNCTION(del, false, NORMAL, ReadStart read = this->__beginRead(key, callPriority); auto guard = this->__writeGuard({ key }, callPriority),
+        (__afterWrites(read, [guard, key = std::move(key)](const DBConRef& ref){ return guard->run([&]() { return ref->del(key); }); })),
+        ([guard, key = std::move(key)](const DBConRef& ref, AsyncDone&& done){ ref->delAsync(key, __forwardWrite(guard, std::move(done))); }),
+        std::string&& key);
     
     /**
     *  \brief DB TTL  Args are moved!
     *
     *  \param key const std::string&
     **/
-    CREATE_FUNCTION(ttl, -1, ([key = std::move(key)](const DBConRef& ref){ return ref->ttl(key); }), std::string&& key);
+    CREATE_ASYNC_FUNCTION(ttl, -1, HIGH, ReadStart read = this->__beginRead(key, callPriority), (__afterWrites(read, [key = std::move(key)](const DBConRef& ref){
+        return DBReturn(ref->ttl(key));
+    })),
+        ([key = std::move(key)](const DBConRef& ref, AsyncDone&& done){ ref->ttlAsync(key, __forward<int>(std::move(done))); }),
+        std::string&& key);
 
     /**
     *  \brief DB PING
     *
     **/
-    CREATE_FUNCTION_NO_ARGS(ping, "false", ([](const DBConRef& ref){ return ref->ping(); }));
+    CREATE_FUNCTION_NO_ARGS(ping, "false", HIGH, ([](const DBConRef& ref){ return ref->ping(); }));
     
+    /**
+    *  \brief One page of the bulk load of all entries with the prefix (runs on the calling thread)
+    *
+    *  \param prefix const std::string&
+    *  \param cursor const std::string& "" for the first page
+    *  \param count size_t
+    **/
+    DBEntryPage scanEntries(const std::string& prefix, const std::string& cursor, size_t count);
+
+    /**
+    *  \brief Attaches the read cache of this connection (before the first call)
+    **/
+    void setCache(const std::shared_ptr<DBCache>& cache) { this->cache = cache; };
+
+    /**
+    *  \brief Read cache of this connection, nullptr if it is disabled
+    **/
+    const std::shared_ptr<DBCache>& getCache() const { return this->cache; };
+
+    /**
+    *  \brief Counters of the connection pool
+    **/
+    DBConnectionPool::Stats getPoolStats() { return this->connections->getStats(); };
+
+    /**
+    *  \brief Counters of the read batcher (all zero if it is disabled)
+    **/
+    DBReadBatcher::Stats getReadBatchStats() const {
+        return this->readBatcher ? this->readBatcher->getStats() : DBReadBatcher::Stats{ 0, 0, 0 };
+    };
+
+    /**
+    *  \brief Counters of the async connector calls (all zero unless redisAsync)
+    **/
+    AsyncStats getAsyncStats() const;
+
+    /**
+    *  \brief Completes the async calls without reply for redisReplyTimeoutMs as failed (expiry tick)
+    *
+    *  \return number of calls that timed out
+    **/
+    size_t expireAsyncCalls();
+
+    /**
+    *  \brief Executor of the async calls (warm-up and write-behind flushes run on it as well)
+    **/
+    Executor& getExecutor() { return *this->executor; };
+
     /**
     *  \brief DB Can execute SQL Query
     *
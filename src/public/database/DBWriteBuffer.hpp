@@ -0,0 +1,160 @@
+#pragma once
+
+#ifndef __DB_WRITE_BUFFER_HPP__
+#define __DB_WRITE_BUFFER_HPP__
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <database/DBWorker.hpp>
+
+/**
+*   \brief Write-behind buffer of one connection
+*
+*   Fire and forget set/setEx calls are kept for a short window, a newer write to the same key replaces the pending one.
+*   A flush thread hands all pending writes as one multi key write to the executor of the worker, so many rewrites of the same
+*   player/vehicle key end up as one DB write.
+*
+*   Memory is bounded by maxBytes, writes that do not fit are rejected and have to be issued directly.
+*
+*   Calls on a key are ordered with the buffered writes of that key: drop() and flushKey() return once no write of the key
+*   is in progress, so the direct call that follows them can not be overtaken by an older buffered value.
+**/
+class DBWriteBuffer {
+public:
+
+    struct Stats {
+        uint64_t buffered; /*!< writes accepted by the buffer */
+        uint64_t absorbed; /*!< writes that were replaced by a newer write before they were flushed */
+        uint64_t issued;   /*!< writes that the database applied */
+        uint64_t failed;   /*!< writes that the database did not apply, their keys are dropped from the cache */
+        uint64_t rejected; /*!< writes that did not fit into the buffer */
+    };
+
+private:
+
+    struct PendingWrite {
+        std::string value;
+        int ttl; /*!< -1 for set */
+    };
+
+    typedef std::unordered_map<std::string, PendingWrite> Batch;
+    typedef std::shared_ptr<Batch> BatchRef;
+
+    std::shared_ptr<DBWorker> worker;
+    std::chrono::milliseconds window;
+    size_t maxBytes;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, PendingWrite> pending;
+    size_t pendingBytes = 0;
+    std::list<BatchRef> queued;               /*!< handed to the executor but not started, oldest first */
+    std::unordered_set<std::string> writing;  /*!< keys whose write is in progress */
+    std::condition_variable writtenCv;        /*!< a write finished */
+    bool stop = false;
+
+    std::thread flusher;
+
+    std::atomic<uint64_t> buffered = 0;
+    std::atomic<uint64_t> absorbed = 0;
+    std::atomic<uint64_t> issued = 0;
+    std::atomic<uint64_t> failed = 0;
+    std::atomic<uint64_t> rejected = 0;
+
+    /**
+    *  \brief Takes all pending writes as a queued batch, their keys are removed from older queued batches (mutex must be held)
+    **/
+    BatchRef __take();
+
+    /**
+    *  \brief Removes the buffered writes of a key from pending and the queued batches (mutex must be held)
+    *
+    *  \param out receives the newest of them
+    *  \return false if there was none
+    **/
+    bool __extract(const std::string& key, PendingWrite& out);
+
+    /**
+    *  \brief Waits until no write of the key is in progress (lock of mutex held)
+    **/
+    void __waitWritten(std::unique_lock<std::mutex>& lock, const std::string& key);
+
+    /**
+    *  \brief Writes a batch once no other write of its keys is in progress, blocks until it is done (executor or flush thread)
+    **/
+    void __writeBatch(const BatchRef& batch);
+
+    /**
+    *  \brief Sends a batch whose keys are marked as writing
+    *
+    *  A batch goes out as one setExMany (one transaction, few round trips), a single key as well.
+    *  If it is not applied the write is lost: it is logged and counted as failed, and its keys are invalidated in the cache.
+    **/
+    void __write(Batch& batch);
+
+    /**
+    *  \brief Unmarks the keys of a written batch
+    **/
+    void __finish(const Batch& batch);
+
+    void __run();
+
+    /**
+    *  \brief Stops and joins the flush thread
+    **/
+    void __stopFlusher();
+
+public:
+
+    DBWriteBuffer(const std::shared_ptr<DBWorker>& worker, std::chrono::milliseconds window, size_t maxBytes);
+    ~DBWriteBuffer();
+
+    DBWriteBuffer() = delete;
+    DBWriteBuffer(const DBWriteBuffer&) = delete;
+    DBWriteBuffer& operator=(const DBWriteBuffer&) = delete;
+    DBWriteBuffer(DBWriteBuffer&&) = delete;
+    DBWriteBuffer& operator=(DBWriteBuffer&&) = delete;
+
+    /**
+    *  \brief Buffers a set (ttl -1) or setEx
+    *
+    *  \return false if the buffer is full or closed, the write has to be issued directly then
+    **/
+    bool write(const std::string& key, const std::string& value, int ttl);
+
+    /**
+    *  \brief Drops the buffered write of a key (it is superseded by a direct set or del)
+    *
+    *  Waits for a write of the key that is already in progress, it must not land after the direct call.
+    **/
+    void drop(const std::string& key);
+
+    /**
+    *  \brief Writes the buffered write of a key on the calling thread (before a read or expire on that key)
+    *
+    *  Returns once the database holds the last buffered value of the key, including a write that was already in progress.
+    **/
+    void flushKey(const std::string& key);
+
+    /**
+    *  \brief Stops the flush thread, writes everything that is pending and waits for it
+    *
+    *  Called on extensionDeInit, the rest is written on the calling thread. Later writes are rejected.
+    **/
+    void close();
+
+    Stats getStats() const;
+};
+
+typedef std::shared_ptr<DBWriteBuffer> WriteBufferRef;
+
+#endif // __DB_WRITE_BUFFER_HPP__
@@ -6,12 +6,6 @@
 #include <database/DBConnector.hpp>
 #include <main.hpp>
 
-// flag to use mysql_library_init()
-// this is not done by mariadbpp, thus it would not be threadsafe to creation and use connections
-namespace MySQLConnector_Detail {
-    static bool is_first_connection = true;
-};
-
 class MySQLConnector : public DBConnector {
 private:
     
@@ -22,6 +16,74 @@ private:
     
     std::vector<DBSQLStatementTemplate> preparedStatements;
 
+    /**
+    *  Fixed key value statements
+    *  Prepared on first use and reused with new parameters, the server parses and plans them once per connection.
+    *  A lost connection drops them, they are prepared again after the reconnect
+    **/
+    enum class Statement : size_t {
+        GET,
+        GET_WITH_TTL,
+        EXISTS,
+        TTL,
+        SET,
+        SET_EX,
+        EXPIRE,
+        DEL,
+        KEYS,
+        SCAN_FIRST,
+        SCAN_NEXT,
+        SCAN_ENTRIES_FIRST,
+        SCAN_ENTRIES_NEXT,
+        SET_MANY,       /*!< bulkRows rows */
+        SET_EX_MANY,    /*!< bulkRows rows */
+        COUNT
+    };
+
+    /**
+    *  Rows per multi row insert of setMany / setExMany
+    *  Full chunks reuse the prepared statement, the rest of a batch is prepared once for that call
+    **/
+    static constexpr size_t bulkRows = 100;
+    std::string statementTexts[static_cast<size_t>(Statement::COUNT)];
+    mariadb::statement_ref statements[static_cast<size_t>(Statement::COUNT)];
+
+    void __initStatementTexts();
+
+    /**
+    *  \brief Upsert of rows entries in one INSERT ... VALUES (..),(..) ON DUPLICATE KEY UPDATE
+    **/
+    std::string __bulkInsertText(size_t rows, bool withTtl) const;
+
+    /**
+    *  \brief Prepared statement, prepares it if needed
+    *
+    *  \throws std::runtime_error if the statement could not be prepared
+    **/
+    mariadb::statement_ref& __prepared(Statement which);
+
+    /**
+    *  \brief Opens a new session, the prepared statements are dropped
+    *
+    *  \throws std::runtime_error if the server can not be reached
+    **/
+    void __reconnect();
+
+    /**
+    *  \brief Runs fnc(statement) with the prepared statement, reconnects and retries once if the session was lost
+    **/
+    template<typename F>
+    auto __run(Statement which, F&& fnc);
+
+    /**
+    *  \brief Writes all entries in chunks of bulkRows rows inside one transaction
+    *
+    *  bind(statement, param, entry) sets the parameters of one row starting at param and advances it.
+    *  A lost session is reconnected and the whole batch is written again once, an sql error rolls back all chunks.
+    **/
+    template<typename E, typename B>
+    bool __writeMany(const std::vector<E>& entries, bool withTtl, B&& bind);
+
     bool __createKeyValueTable(const std::string& tablename);
 
 public:
@@ -39,10 +101,13 @@ public:
     *  Key
     */
     std::vector<std::string> keys(const std::string& prefix);
+    DBKeyPage scanKeys(const std::string& prefix, const std::string& cursor, size_t count);
     std::string get(const std::string& key);
     std::string getRange(const std::string& key, unsigned int from, unsigned int to);
     std::pair<std::string, int> getWithTtl(const std::string& key);
     bool exists(const std::string& key);
+    DBEntryPage scanEntries(const std::string& prefix, const std::string& cursor, size_t count);
+    std::vector<std::string> getMany(const std::vector<std::string>& keys);
 
     /*
     *  DB SET / SETEX
@@ -50,6 +115,8 @@ public:
     bool set(const std::string& key, const std::string& value);
     bool setEx(const std::string& key, int ttl, const std::string& value);
     bool expire(const std::string& key, int ttl);
+    bool setMany(const std::vector<DBKeyValue>& entries);
+    bool setExMany(const std::vector<DBKeyEntry>& entries);
     
     /*
     *  DB DEL
@@ -6,12 +6,38 @@
 #include <cpp_redis/misc/error.hpp>
 
 #include <database/DBConnector.hpp>
+#include <chrono>
+#include <future>
 #include <main.hpp>
 
+/**
+*   Redis connector
+*
+*   By default a call sends its commands and waits for all replies (sync_commit), the pool hands the connector to one caller at a time.
+*   In pipelined mode (redisPipeline) the connector is shared: a call queues its commands, sends whatever is queued (commit)
+*   and waits only for its own replies, so the commands of concurrent calls go out together.
+*
+*   Pipelined connectors also implement the async calls: the reply callback of cpp_redis completes the call,
+*   no thread waits for the reply and any number of commands can be in flight on one connection.
+**/
 class RedisConnector : public DBConnector {
 
 private:
     DBConfig config;
+    bool pipelined = false;
+    std::chrono::milliseconds replyTimeout;
+
+    /**
+    *  \brief Sends the queued commands, waits for all replies unless pipelined
+    **/
+    void __commit();
+
+    /**
+    *  \brief Waits for the reply of one command
+    *
+    *  \throws std::runtime_error if it does not arrive within replyTimeout
+    **/
+    cpp_redis::reply __await(std::future<cpp_redis::reply>& reply);
     
 public:
 
@@ -20,7 +46,7 @@ public:
     RedisConnector(RedisConnector&&) = delete;
     RedisConnector& operator=(RedisConnector&&) = delete;
 
-    RedisConnector(const DBConfig& Config);
+    RedisConnector(const DBConfig& config);
     ~RedisConnector();
 
     std::shared_ptr<cpp_redis::client> client;
@@ -30,10 +56,13 @@ public:
     *  Key
     */
     std::vector<std::string> keys(const std::string& prefix);
+    DBKeyPage scanKeys(const std::string& prefix, const std::string& cursor, size_t count);
     std::string get(const std::string& key);
     std::string getRange(const std::string& key, unsigned int from, unsigned int to);
     std::pair<std::string, int> getWithTtl(const std::string& key);
     bool exists(const std::string& key);
+    DBEntryPage scanEntries(const std::string& prefix, const std::string& cursor, size_t count);
+    std::vector<std::string> getMany(const std::vector<std::string>& keys);
 
     /*
     *  DB SET / SETEX
@@ -41,6 +70,8 @@ public:
     bool set(const std::string& key, const std::string& value);
     bool setEx(const std::string& key, int ttl, const std::string& value);
     bool expire(const std::string& key, int ttl);
+    bool setMany(const std::vector<DBKeyValue>& entries);
+    bool setExMany(const std::vector<DBKeyEntry>& entries);
     
     /*
     *  DB DEL
@@ -58,6 +89,22 @@ public:
     *  Key
     */
     int ttl(const std::string& key);
+
+    bool isShareable() { return this->pipelined; };
+
+    /*
+    *  Async calls, pipelined only
+    *  done runs on the network thread of cpp_redis, error and nil replies complete with the same defaults as the sync calls
+    */
+    bool supportsAsync() { return this->pipelined; };
+    void getAsync(const std::string& key, DBCompletion<std::string>&& done);
+    void getWithTtlAsync(const std::string& key, DBCompletion<std::pair<std::string, int>>&& done);
+    void existsAsync(const std::string& key, DBCompletion<bool>&& done);
+    void setAsync(const std::string& key, const std::string& value, DBCompletion<bool>&& done);
+    void setExAsync(const std::string& key, int ttl, const std::string& value, DBCompletion<bool>&& done);
+    void expireAsync(const std::string& key, int ttl, DBCompletion<bool>&& done);
+    void delAsync(const std::string& key, DBCompletion<bool>&& done);
+    void ttlAsync(const std::string& key, DBCompletion<int>&& done);
 };
 
 #endif
@@ -53,10 +53,13 @@ public:
     *  Key
     **/
     std::vector<std::string> keys(const std::string& prefix);
+    DBKeyPage scanKeys(const std::string& prefix, const std::string& cursor, size_t count);
     std::string get(const std::string& key);
     std::string getRange(const std::string& key, unsigned int from, unsigned int to);
     std::pair<std::string, int> getWithTtl(const std::string& key);
     bool exists(const std::string& key);
+    DBEntryPage scanEntries(const std::string& prefix, const std::string& cursor, size_t count);
+    std::vector<std::string> getMany(const std::vector<std::string>& keys);
 
     /**
     *  DB SET / SETEX
@@ -65,6 +68,8 @@ public:
     bool set(const std::string& key, const std::string& value);
     bool setEx(const std::string& key, int ttl, const std::string& value);
     bool expire(const std::string& key, int ttl);
+    bool setMany(const std::vector<DBKeyValue>& entries);
+    bool setExMany(const std::vector<DBKeyEntry>& entries);
 
     /**
     *  DB DEL
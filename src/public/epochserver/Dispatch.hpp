@@ -0,0 +1,200 @@
+#pragma once
+
+#ifndef __EPOCH_DISPATCH_HPP__
+#define __EPOCH_DISPATCH_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <stdexcept>
+
+/**
+*   Compile time dispatch table for Arma's callExtension
+*
+*   Every function name and every numeric code is resolved to the numeric code
+*   that is handled by EpochServer::callExtensionEntrypointByNumber.
+*   The lookup is a minimal perfect hash (hash and displace) that is built by the compiler,
+*   so resolving a call costs one hash over the function name and one string compare.
+**/
+namespace dispatch {
+
+    struct Entry {
+        std::string_view name;
+        const char* code;
+    };
+
+    /**
+    *  \brief Callable names and their numeric codes
+    *
+    *  Add new functions here, the table below is rebuilt automatically
+    **/
+    constexpr Entry entries[] = {
+        // util
+        { "00", "00" }, { "getCurrentTime", "00" },
+        { "01", "01" }, { "getRandomString", "01" },
+        { "02", "02" }, { "getStringMd5", "02" },
+
+        // db
+        { "10", "10" }, { "dbPing", "10" },
+        { "11", "11" }, { "dbGet", "11" },
+        { "12", "12" }, { "dbGetTtl", "12" },
+        { "13", "13" }, { "dbSet", "13" },
+        { "14", "14" }, { "dbSetEx", "14" },
+        { "15", "15" }, { "dbQuery", "15" },
+        { "16", "16" }, { "dbExists", "16" },
+        { "17", "17" }, { "dbExpire", "17" },
+        { "18", "18" }, { "dbDel", "18" },
+        { "19", "19" }, { "dbGetRange", "19" },
+
+        // be
+        { "20", "20" }, { "beBroadcastMessage", "20" },
+        { "21", "21" }, { "beKick", "21" },
+        { "22", "22" }, { "beBan", "22" },
+        { "23", "23" }, { "beLock", "23" },
+        { "24", "24" }, { "beUnlock", "24" },
+        { "25", "25" }, { "beShutdown", "25" },
+
+        // steamapi
+        { "30", "30" }, { "playerCheck", "30" },
+
+        // db (ticketed, results are polled with pollTicket)
+        { "40", "40" }, { "dbTicketPing", "40" },
+        { "41", "41" }, { "dbTicketGet", "41" },
+        { "42", "42" }, { "dbTicketGetTtl", "42" },
+        { "43", "43" }, { "dbTicketSet", "43" },
+        { "44", "44" }, { "dbTicketSetEx", "44" },
+        { "46", "46" }, { "dbTicketExists", "46" },
+        { "47", "47" }, { "dbTicketExpire", "47" },
+        { "48", "48" }, { "dbTicketDel", "48" },
+        { "49", "49" }, { "dbTicketGetRange", "49" },
+
+        // stats
+        { "50", "50" }, { "dbStats", "50" },
+        { "51", "51" }, { "dbCacheStatus", "51" },
+
+        // db key listing and bulk writes (results are polled with pollTicket)
+        { "60", "60" }, { "dbScanKeys", "60" },
+        { "61", "61" }, { "dbSetMany", "61" },
+        { "62", "62" }, { "dbSetExMany", "62" },
+
+        // extension info
+        { "90", "90" }, { "version", "90" },
+        { "91", "91" }, { "log", "91" },
+        { "92", "92" }, { "pollBatch", "92" },
+        { "93", "93" }, { "pollTicket", "93" }
+    };
+
+    constexpr size_t entryCount = sizeof(entries) / sizeof(Entry);
+
+    /**
+    *  \brief FNV-1a variant with a seed, as used for hash and displace
+    **/
+    constexpr uint32_t hash(uint32_t seed, std::string_view str) {
+        uint32_t h = seed == 0 ? 0x01000193u : seed;
+        for (char c : str) {
+            h = (h * 0x01000193u) ^ static_cast<uint8_t>(c);
+        }
+        return h;
+    }
+
+    template<size_t N>
+    struct PerfectHashTable {
+        int32_t displacement[N] = {}; /*!< seed per bucket, negative values are direct slots (-slot - 1) */
+        size_t slots[N] = {};         /*!< slot -> index in entries */
+    };
+
+    /**
+    *  \brief Builds the minimal perfect hash over all entries
+    *
+    *  Buckets are placed from the largest to the smallest, a bucket is placed by searching a seed
+    *  that maps all of its names to free slots. Single name buckets take the remaining slots directly.
+    *  Fails to compile on duplicate names.
+    **/
+    template<size_t N>
+    constexpr PerfectHashTable<N> buildTable(const Entry (&list)[N]) {
+        PerfectHashTable<N> table;
+
+        size_t bucketOf[N] = {};
+        size_t bucketSize[N] = {};
+        bool used[N] = {};
+
+        for (size_t i = 0; i < N; ++i) {
+            bucketOf[i] = hash(0, list[i].name) % N;
+            ++bucketSize[bucketOf[i]];
+        }
+
+        for (size_t size = N; size > 1; --size) {
+            for (size_t b = 0; b < N; ++b) {
+                if (bucketSize[b] != size) continue;
+
+                for (uint32_t seed = 1;; ++seed) {
+                    if (seed > 1000000u) throw std::logic_error("dispatch: could not build perfect hash (duplicate name?)");
+
+                    size_t tried[N] = {};
+                    size_t triedCount = 0;
+                    bool ok = true;
+
+                    for (size_t i = 0; i < N && ok; ++i) {
+                        if (bucketOf[i] != b) continue;
+                        size_t slot = hash(seed, list[i].name) % N;
+                        if (used[slot]) {
+                            ok = false;
+                        }
+                        for (size_t t = 0; t < triedCount && ok; ++t) {
+                            if (tried[t] == slot) ok = false;
+                        }
+                        tried[triedCount++] = slot;
+                    }
+
+                    if (!ok) continue;
+
+                    triedCount = 0;
+                    for (size_t i = 0; i < N; ++i) {
+                        if (bucketOf[i] != b) continue;
+                        size_t slot = tried[triedCount++];
+                        used[slot] = true;
+                        table.slots[slot] = i;
+                    }
+                    table.displacement[b] = static_cast<int32_t>(seed);
+                    break;
+                }
+            }
+        }
+
+        size_t freeSlot = 0;
+        for (size_t i = 0; i < N; ++i) {
+            if (bucketSize[bucketOf[i]] != 1) continue;
+            while (used[freeSlot]) ++freeSlot;
+            used[freeSlot] = true;
+            table.slots[freeSlot] = i;
+            table.displacement[bucketOf[i]] = -static_cast<int32_t>(freeSlot) - 1;
+        }
+
+        return table;
+    }
+
+    constexpr PerfectHashTable<entryCount> table = buildTable(entries);
+
+    /**
+    *  \brief Resolves a function name or numeric code
+    *
+    *  \return numeric code (2 chars) or nullptr if the function is unknown
+    **/
+    constexpr const char* lookup(std::string_view function) {
+        int32_t d = table.displacement[hash(0, function) % entryCount];
+        size_t slot = d < 0 ? static_cast<size_t>(-d - 1) : hash(static_cast<uint32_t>(d), function) % entryCount;
+        const Entry& entry = entries[table.slots[slot]];
+        return entry.name == function ? entry.code : nullptr;
+    }
+
+    constexpr bool verifyTable() {
+        for (size_t i = 0; i < entryCount; ++i) {
+            if (lookup(entries[i].name) != entries[i].code) return false;
+        }
+        return lookup("unknown") == nullptr;
+    }
+
+    static_assert(verifyTable(), "dispatch table is not a perfect hash");
+};
+
+#endif // __EPOCH_DISPATCH_HPP__
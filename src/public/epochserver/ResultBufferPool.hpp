@@ -0,0 +1,81 @@
+#pragma once
+
+#ifndef __RESULT_BUFFER_POOL_HPP__
+#define __RESULT_BUFFER_POOL_HPP__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstring>
+#include <algorithm>
+
+/**
+* Result that is delivered to SQF in chunks
+**/
+struct ResultDelivery {
+    std::string buffer; /*!< pooled result buffer */
+    size_t offset = 0;  /*!< bytes already handed to SQF */
+
+    /**
+    *  \brief Copies the next chunk into Arma's output buffer (incl. terminator)
+    *
+    *  \param written bytes of the output that are already used
+    *  \return true if there is more to deliver
+    **/
+    bool writeChunk(char* output, int outputSize, size_t written) {
+        // one byte of the output is needed for the terminator
+        size_t chunkSize = static_cast<size_t>(outputSize) - 1;
+        size_t count = std::min(chunkSize - written, this->buffer.size() - this->offset);
+
+        std::memcpy(output + written, this->buffer.data() + this->offset, count);
+        output[written + count] = '\0';
+        this->offset += count;
+
+        return this->offset < this->buffer.size();
+    }
+};
+
+/**
+*   \brief Pool of result buffers for the callback queue
+*
+*   Serialized results are written into recycled buffers instead of fresh heap allocations.
+*   Buffers are kept in power of two size classes, so large player blobs (~100k chars)
+*   reuse the same allocation over and over.
+*
+*   acquire() may be called from any thread.
+*   release() never blocks: if the pool is contended or full, the buffer is simply freed.
+**/
+class ResultBufferPool {
+private:
+
+    static constexpr size_t minClass = 8;   /*!< 256 bytes */
+    static constexpr size_t maxClass = 20;  /*!< 1 MB, bigger buffers are never kept */
+    static constexpr size_t classCount = maxClass - minClass + 1;
+
+    std::mutex mutex;
+    std::vector<std::string> freeLists[classCount];
+
+    size_t retainedBytes = 0;
+    size_t maxRetainedBytes;
+
+public:
+
+    ResultBufferPool(size_t maxRetainedBytes = 8 * 1024 * 1024);
+
+    ResultBufferPool(const ResultBufferPool&) = delete;
+    ResultBufferPool& operator=(const ResultBufferPool&) = delete;
+    ResultBufferPool(ResultBufferPool&&) = delete;
+    ResultBufferPool& operator=(ResultBufferPool&&) = delete;
+
+    /**
+    *  \brief Get an empty buffer with at least the given capacity
+    **/
+    std::string acquire(size_t capacity);
+
+    /**
+    *  \brief Give a buffer back to the pool
+    **/
+    void release(std::string&& buffer);
+};
+
+#endif // __RESULT_BUFFER_POOL_HPP__
@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef __TICKET_TABLE_HPP__
+#define __TICKET_TABLE_HPP__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+
+#include <database/DBWorker.hpp>
+#include <epochserver/ResultBufferPool.hpp>
+#include <main.hpp>
+
+/**
+*   \brief Result slots for ASYNC_POLL requests
+*
+*   Every request reserves a slot and gets a ticket back (generation << indexBits | index).
+*   The worker stores the serialized result in the slot, SQF polls its ticket and receives
+*   exactly that result, so a slow query does not hold back any other request.
+*
+*   reserve() and poll() are synchronized, fulfill() never locks (the slot is owned by the worker until it is ready).
+*   Results that are not collected within staleSeconds are reclaimed when the table runs full.
+**/
+class TicketTable {
+public:
+
+    static constexpr unsigned int indexBits = 12;
+    static constexpr unsigned int generationBits = 12; /*!< tickets stay below 2^24, so they survive SQF's float numbers */
+    static constexpr unsigned int capacity = 1u << indexBits;
+    static constexpr long long staleSeconds = 300;
+
+private:
+
+    enum SlotState : uint8_t {
+        SLOT_FREE,
+        SLOT_PENDING,
+        SLOT_READY
+    };
+
+    struct Slot {
+        std::atomic<uint8_t> state{ SLOT_FREE };
+        unsigned int generation = 0;
+        ResultDelivery result;
+        utils::timestamp readyAt;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::vector<unsigned int> freeSlots;
+    std::mutex mutex;
+
+    /**
+    *  \brief Frees all results that were never collected (mutex must be held)
+    **/
+    void __reclaimStale();
+
+    /**
+    *  \brief Puts a slot back to the free list (mutex must be held)
+    **/
+    void __free(unsigned int index);
+
+public:
+
+    TicketTable();
+
+    TicketTable(const TicketTable&) = delete;
+    TicketTable& operator=(const TicketTable&) = delete;
+    TicketTable(TicketTable&&) = delete;
+    TicketTable& operator=(TicketTable&&) = delete;
+
+    /**
+    *  \brief Reserves a slot for a new request
+    *
+    *  \throws std::runtime_error if all slots are in use
+    **/
+    DBTicket reserve();
+
+    /**
+    *  \brief Stores the serialized result of the request (worker thread)
+    **/
+    void fulfill(DBTicket ticket, std::string&& result);
+
+    /**
+    *  \brief Frees the slot of a request that will never be fulfilled (rejected before it ran)
+    **/
+    void cancel(DBTicket ticket);
+
+    /**
+    *  \brief Delivers the next chunk of the ticket's result into Arma's output
+    *
+    *  The slot is freed and its buffer given back to the pool once the last chunk is delivered.
+    *
+    *  \return 0 done, 100 more chunks follow, 102 not ready yet, 103 unknown or expired ticket
+    **/
+    int poll(DBTicket ticket, char* output, int outputSize, ResultBufferPool& pool);
+};
+
+#endif // __TICKET_TABLE_HPP__
@@ -8,6 +8,11 @@
 #include <RCon/RCON.hpp>
 #include <RCon/Whitelist.hpp>
 #include <SteamAPI/SteamAPI.hpp>
+#include <epochserver/Dispatch.hpp>
+#include <epochserver/ResultBufferPool.hpp>
+#include <epochserver/TicketTable.hpp>
+#include <threading/MPSCQueue.hpp>
+#include <threading/Executor.hpp>
 #include <main.hpp>
 
 #undef GetObject
@@ -24,12 +29,26 @@ struct SQFCallBackHandle {
 
     std::string extraArg;
 
+    size_t stringSize() const {
+        return 13 + result.size() + function.size() + extraArg.size();
+    }
+
     void toString(std::string& out) const {
-        out.reserve(9 + result.size() + function.size() + extraArg.size());
-        out = "[\"" + function + "\"," + std::to_string(functionIsCode) + "," + result + ",\"" + (extraArg.empty() ? "" : extraArg) + "\"]";
+        out.clear();
+        out.reserve(this->stringSize());
+        out += "[\"";
+        out += function;
+        out += "\",";
+        out += std::to_string(functionIsCode);
+        out += ",";
+        out += result;
+        out += ",\"";
+        out += extraArg;
+        out += "\"]";
     }
 };
 
+
 class EpochServer {
 private:
     
@@ -44,6 +63,12 @@ private:
     * Whitelist and vpn detection
     **/
     std::shared_ptr<Whitelist> whitelist = nullptr;
+
+    /**
+    * Runs the Steam API player checks, so slow HTTP requests do not hold back anything else
+    * (declared after steamApi and rcon, its tasks use them)
+    **/
+    std::unique_ptr<Executor> steamApiExecutor;
     
     /**
     * Database Access
@@ -57,19 +82,68 @@ private:
     void __setupRCON(const rapidjson::Value& config);
     void __setupSteamAPI(const rapidjson::Value& config);
 
-    void dbEntrypoint(std::string& out, int outputSize, int& outCode, const char *function, const char **args, int argsCnt);
     void dbEntrypoint(std::string& out, int outputSize, int& outCode, const char function, const char **args, int argsCnt);
-    void beEntrypoint(std::string& out, int outputSize, int& outCode, const char *function, const char **args, int argsCnt);
+    /**
+    *  \brief Answers get (11), getTtl (12) and exists (16) from the worker cache
+    *
+    *  On a hit the SQF value is set as result with code 2, nothing is queued.
+    *  Keys the cache knows to be missing are answered the same way with the result of a missing key.
+    *  Misses and values that do not fit into the output go the async way.
+    *
+    *  \return true on a hit
+    **/
+    bool __serveFromCache(std::string& out, int outputSize, int& outCode, const char function, const char *workerName, const char *key);
+
+    void dbTicketEntrypoint(std::string& out, int outputSize, int& outCode, const char function, const char **args, int argsCnt);
     void beEntrypoint(std::string& out, int outputSize, int& outCode, const char function, const char **args, int argsCnt);
     void callExtensionEntrypointByNumber(std::string& out, int outputSize, int& outCode, const char *function, const char **args, int argsCnt);
 
+    /**
+    *  \brief Copies the next chunk of a delivery slot straight into the output (game thread only)
+    *
+    *  \param delivery currentResult or currentBatch, reset once it is done
+    *  \param written bytes of the output that are already used
+    *  \return 100 if there is more to deliver, 0 if done
+    **/
+    int __deliverChunk(std::optional<ResultDelivery>& delivery, char* output, int outputSize, size_t written);
+
+    /**
+    *  \brief Single result callback poll (game thread only)
+    **/
+    int __pollResult(char* output, int outputSize);
+
+    /**
+    *  \brief Packs as many queued results as fit into one SQF array (game thread only)
+    *
+    *  If the last packed result does not fit, the rest of the array is delivered in chunks (code 100)
+    **/
+    int __pollResultsBatched(char* output, int outputSize);
+
+    /**
+    *  \brief Polls the result of one ASYNC_POLL ticket (game thread only)
+    **/
+    int __pollTicket(char* output, int outputSize, const char **args, int argsCnt);
+
     /**
     * Results (only for callback polling)
+    * 
+    * Filled by the db workers, drained by the game thread. Never locks
     **/
 
-    std::queue< std::pair<std::string, size_t> > results; /*!< results storage */
+    MPSCQueue<std::string> results; /*!< results storage */
 
-    std::mutex resultsMutex; /*!< mutex for results storage */
+    ResultBufferPool resultBuffers; /*!< recycled storage for the serialized results */
+
+    /**
+    * Chunked deliveries, one slot per poll code (game thread only)
+    *
+    * "90" and "92" may both be polled while the other one is in the middle of a chunked delivery,
+    * each continues its own slot: "90" never gets the tail of a "92" array and "92" never gets the tail of a single result.
+    **/
+    std::optional<ResultDelivery> currentResult; /*!< single result of "90" that is delivered in chunks */
+    std::optional<ResultDelivery> currentBatch;  /*!< tail of a "92" array that is delivered in chunks */
+
+    TicketTable tickets; /*!< results of ASYNC_POLL requests */
 
 public:
     
@@ -117,6 +191,21 @@ public:
     **/
     void log(const std::string& log);
 
+    /**
+    *  \brief Get the db counters as SQF array [[name, value], ...]
+    **/
+    std::string getStats();
+
+    /**
+    *  \brief Get the cache warm-up status as SQF array [[name, "cold"|"warming"|"warm", keys, warmupMs], ...]
+    **/
+    std::string getCacheStatus();
+
+    /**
+    *  \brief Writes out all write-behind buffers (extensionDeInit)
+    **/
+    void flushWrites();
+
     /**
     *   \brief Internal method to insert callback into callback queue
     *
@@ -126,6 +215,23 @@ public:
     *
     **/
     void insertCallback(const SQFCallBackHandle& cb);
+
+    /**
+    *   \brief Reserves a ticket for a ASYNC_POLL request
+    *
+    *   \throws std::runtime_error if there are too many pending tickets
+    **/
+    DBTicket reserveTicket();
+
+    /**
+    *   \brief Stores the result of a ASYNC_POLL request, it can be polled with its ticket (93) afterwards
+    **/
+    void insertTicketResult(DBTicket ticket, const DBReturn& result);
+
+    /**
+    *   \brief Frees the ticket of a ASYNC_POLL request that was rejected before it ran
+    **/
+    void cancelTicket(DBTicket ticket);
 };
 
 #endif //__EPOCHLIB_H__
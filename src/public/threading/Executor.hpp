@@ -0,0 +1,181 @@
+#pragma once
+
+#ifndef __EXECUTOR_HPP__
+#define __EXECUTOR_HPP__
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+*   \brief Bounded executor with its own worker threads and priority lanes
+*
+*   Every subsystem that blocks on I/O (each db connection, each HTTP integration) gets one,
+*   so a slow MySQL server or a stalled HTTP request only delays the calls of that subsystem.
+*
+*   Tasks are queued in one FIFO lane per priority, the workers take from the highest lane first.
+*   A task of a lower lane is taken before the tasks of a higher lane that were queued more than
+*   agingStep per lane after it, so low priority work is delayed by a burst of high priority work but never starved by it.
+*
+*   All lanes together hold at most capacity tasks, submitting to a full queue throws instead of blocking the caller
+*   (the game thread must never wait for a stalled backend).
+*   Queue depth and the time tasks waited in the queue are counted per lane (getStats).
+*
+*   Tasks that are still queued on destruction are run before the threads are joined.
+**/
+class Executor {
+public:
+
+    enum class Priority : uint8_t {
+        HIGH,   /*!< reads the game is waiting for */
+        NORMAL,
+        LOW     /*!< bulk and background work */
+    };
+
+    static constexpr size_t laneCount = 3;
+
+    struct LaneStats {
+        size_t queued;          /*!< tasks currently waiting */
+        uint64_t executed;      /*!< tasks taken from the queue */
+        uint64_t waitMicros;    /*!< total time tasks spent in the queue */
+        uint64_t maxWaitMicros;
+    };
+
+    struct Stats {
+        size_t threads;
+        size_t queued;          /*!< tasks currently waiting in all lanes */
+        size_t maxQueued;       /*!< highest queue depth seen */
+        uint64_t executed;
+        uint64_t rejected;      /*!< tasks that did not fit into the queue */
+        uint64_t aged;          /*!< tasks that were taken before higher lanes because of their wait time */
+        uint64_t waitMicros;
+        uint64_t maxWaitMicros;
+        LaneStats lanes[laneCount];
+    };
+
+private:
+
+    struct Task {
+        std::function<void()> fnc;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    std::string name;
+    size_t capacity;
+    std::chrono::steady_clock::duration agingStep;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Task> lanes[laneCount];
+    size_t queued = 0;
+    bool stop = false;
+
+    std::vector<std::thread> workers;
+
+    /*!< executor whose worker thread this is, nullptr on other threads */
+    static thread_local const Executor* current;
+
+    /*!< counters, guarded by the mutex */
+    size_t maxQueued = 0;
+    uint64_t rejected = 0;
+    uint64_t aged = 0;
+    uint64_t executed[laneCount] = {};
+    uint64_t waitMicros[laneCount] = {};
+    uint64_t maxWaitMicros[laneCount] = {};
+
+    /**
+    *  \brief Queues a task
+    *
+    *  \throws std::runtime_error if the queue is full or the executor is stopped
+    **/
+    void __push(std::function<void()>&& fnc, Priority priority);
+
+    /**
+    *  \brief Lane of the next task
+    *
+    *  A task is due lane * agingStep after it was queued, the front that is due first is taken (the higher lane on a tie).
+    *  The mutex must be held and a task must be queued.
+    **/
+    size_t __nextLane();
+
+    void __run();
+
+public:
+
+    /**
+    *  \param name used in log and error messages
+    *  \param threads worker threads (at least one)
+    *  \param capacity maximum number of queued tasks (0 = unbounded)
+    *  \param agingStep head start of a task over the tasks of the next lower lane
+    **/
+    Executor(const std::string& name, size_t threads, size_t capacity, std::chrono::milliseconds agingStep = std::chrono::milliseconds(250));
+    ~Executor();
+
+    Executor() = delete;
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+    Executor& operator=(Executor&&) = delete;
+
+    /**
+    *  \brief Runs f on a worker thread, the future holds its result or exception
+    *
+    *  \throws std::runtime_error if the queue is full
+    **/
+    template<class F>
+    auto enqueue(F&& f, Priority priority = Priority::NORMAL) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        // packaged_task is move only, std::function needs a copyable target
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto result = task->get_future();
+        this->__push([task]() { (*task)(); }, priority);
+        return result;
+    };
+
+    /**
+    *  \brief Runs f on a worker thread, exceptions are logged and dropped
+    *
+    *  \throws std::runtime_error if the queue is full
+    **/
+    template<class F>
+    void fireAndForget(F&& f, Priority priority = Priority::NORMAL) {
+        this->__push(std::function<void()>(std::forward<F>(f)), priority);
+    };
+
+    size_t getThreadCount() const { return this->workers.size(); };
+
+    /**
+    *  \brief Whether the calling thread is one of the worker threads
+    **/
+    bool isCurrent() const { return current == this; };
+
+    const std::string& getName() const { return this->name; };
+
+    Stats getStats();
+
+    /**
+    *  \brief Appends the counters as (prefix.execName, value), as used by the dbStats function
+    **/
+    void appendStats(std::vector<std::pair<std::string, uint64_t>>& out, const std::string& prefix);
+
+    /**
+    *  \brief Parses "high", "normal" or "low"
+    *
+    *  \throws std::runtime_error on anything else
+    **/
+    static Priority parsePriority(const std::string_view& str);
+};
+
+#endif // __EXECUTOR_HPP__
@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef __MPSC_QUEUE_HPP__
+#define __MPSC_QUEUE_HPP__
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+/**
+*   \brief Lock-free multi producer / single consumer queue
+*
+*   Node based queue (D. Vyukov): producers only do one atomic exchange on the head,
+*   the consumer owns the tail and never blocks.
+*   A push that is still linking its node is not visible to the consumer yet,
+*   in that case the queue simply reports empty for that poll.
+*
+*   push() may be called from any thread, pop() and empty() only from the consumer thread.
+**/
+template<typename T>
+class MPSCQueue {
+private:
+
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        std::optional<T> value;
+    };
+
+    std::atomic<Node*> head; /*!< last pushed node (producers) */
+    Node* tail;              /*!< stub node before the oldest element (consumer) */
+
+public:
+
+    MPSCQueue() {
+        Node* stub = new Node();
+        this->head.store(stub, std::memory_order_relaxed);
+        this->tail = stub;
+    }
+
+    ~MPSCQueue() {
+        Node* node = this->tail;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+    MPSCQueue(MPSCQueue&&) = delete;
+    MPSCQueue& operator=(MPSCQueue&&) = delete;
+
+    /**
+    *  \brief Enqueue an element (any thread)
+    **/
+    void push(T&& value) {
+        Node* node = new Node();
+        node->value.emplace(std::move(value));
+        Node* prev = this->head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+    *  \brief Dequeue the oldest element (consumer thread only)
+    *
+    *  \return false if there is nothing to dequeue
+    **/
+    bool pop(T& out) {
+        Node* next = this->tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        out = std::move(*next->value);
+        next->value.reset();
+
+        delete this->tail;
+        this->tail = next;
+        return true;
+    }
+
+    /**
+    *  \brief Checks for published elements (consumer thread only)
+    **/
+    bool empty() const {
+        return this->tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // __MPSC_QUEUE_HPP__
@@ -0,0 +1,192 @@
+#pragma once
+
+#ifndef __TIMING_WHEEL_HPP__
+#define __TIMING_WHEEL_HPP__
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+*   \brief Links of an item in a TimingWheel, embedded in the item
+**/
+template<typename T>
+struct TimingWheelHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+    int64_t deadline = -1; /*!< -1 while the item is not scheduled */
+    uint16_t slot = 0;     /*!< level * slotCount + slot in the level */
+};
+
+/**
+*   \brief Hierarchical timing wheel with a resolution of one time unit
+*
+*   4 levels with 64 slots each cover 64^4 units (~194 days in seconds), later deadlines are parked in the last slot
+*   and rescheduled when it is cascaded. Items are cascaded to the lower levels as time advances
+*   and handed to the callback once their deadline is reached.
+*
+*   Intrusive: the wheel only links the items, every item embeds a TimingWheelHook that HookOf()(item) returns.
+*   Schedule, reschedule and cancel are O(1), an item is in the wheel at most once.
+*   Items must be cancelled before they are destroyed. Not synchronized.
+**/
+template<typename T, typename HookOf>
+class TimingWheel {
+private:
+
+    static constexpr unsigned int levelBits = 6;
+    static constexpr unsigned int slotCount = 1u << levelBits;
+    static constexpr unsigned int levelCount = 4;
+
+    T* slots[levelCount * slotCount] = {};
+    int64_t current;
+    size_t count = 0;
+
+    static TimingWheelHook<T>& __hook(T* item) {
+        return HookOf()(item);
+    }
+
+    void __link(T* item, unsigned int slot) {
+        auto& hook = __hook(item);
+        hook.slot = static_cast<uint16_t>(slot);
+        hook.prev = nullptr;
+        hook.next = this->slots[slot];
+        if (hook.next) {
+            __hook(hook.next).prev = item;
+        }
+        this->slots[slot] = item;
+    }
+
+    void __unlink(T* item) {
+        auto& hook = __hook(item);
+        if (hook.prev) {
+            __hook(hook.prev).next = hook.next;
+        }
+        else {
+            this->slots[hook.slot] = hook.next;
+        }
+        if (hook.next) {
+            __hook(hook.next).prev = hook.prev;
+        }
+        hook.prev = nullptr;
+        hook.next = nullptr;
+    }
+
+    void __place(T* item, int64_t deadline) {
+        __hook(item).deadline = deadline;
+
+        int64_t delta = deadline - this->current;
+        if (delta < 0) {
+            delta = 0;
+            deadline = this->current;
+        }
+
+        for (unsigned int level = 0; level < levelCount; ++level) {
+            if (delta < (static_cast<int64_t>(1) << (levelBits * (level + 1)))) {
+                auto slot = (deadline >> (levelBits * level)) & (slotCount - 1);
+                this->__link(item, level * slotCount + static_cast<unsigned int>(slot));
+                return;
+            }
+        }
+
+        // out of range, park it in the slot of the last level that is cascaded last
+        auto slot = ((this->current >> (levelBits * (levelCount - 1))) + slotCount - 1) & (slotCount - 1);
+        this->__link(item, (levelCount - 1) * slotCount + static_cast<unsigned int>(slot));
+    }
+
+public:
+
+    explicit TimingWheel(int64_t now) : current(now) {}
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    /**
+    *  \brief Schedules or reschedules an item, deadlines in the past fire on the next tick
+    *
+    *  An item that is already scheduled for the same deadline stays where it is.
+    **/
+    void schedule(T* item, int64_t deadline) {
+        if (deadline <= this->current) {
+            deadline = this->current + 1;
+        }
+
+        auto& hook = __hook(item);
+        if (hook.deadline == deadline) return;
+
+        if (hook.deadline >= 0) {
+            this->__unlink(item);
+        }
+        else {
+            ++this->count;
+        }
+        this->__place(item, deadline);
+    }
+
+    /**
+    *  \brief Removes an item from the wheel, no-op if it is not scheduled
+    **/
+    void cancel(T* item) {
+        auto& hook = __hook(item);
+        if (hook.deadline < 0) return;
+
+        this->__unlink(item);
+        hook.deadline = -1;
+        --this->count;
+    }
+
+    /**
+    *  \brief Advances to now, calls onExpired(item) for every item that is due
+    *
+    *  The item is unlinked before the call, the callback may destroy it.
+    **/
+    template<typename F>
+    void advance(int64_t now, F&& onExpired) {
+        while (this->current < now) {
+            ++this->current;
+            int64_t t = this->current;
+
+            // cascade from the highest level down, so items can drop through several levels at once
+            for (unsigned int level = levelCount - 1; level > 0; --level) {
+                if ((t & ((static_cast<int64_t>(1) << (levelBits * level)) - 1)) != 0) continue;
+
+                auto slot = level * slotCount + static_cast<unsigned int>((t >> (levelBits * level)) & (slotCount - 1));
+                // detached first, parked items may be placed into the same slot again
+                T* item = this->slots[slot];
+                this->slots[slot] = nullptr;
+                while (item) {
+                    T* next = __hook(item).next;
+                    this->__place(item, __hook(item).deadline);
+                    item = next;
+                }
+            }
+
+            // the callback can only schedule into other slots, deadlines are at least one unit ahead
+            auto due = static_cast<unsigned int>(t & (slotCount - 1));
+            while (T* item = this->slots[due]) {
+                this->__unlink(item);
+                __hook(item).deadline = -1;
+                --this->count;
+                onExpired(item);
+            }
+        }
+    }
+
+    /**
+    *  \brief Forgets all items without touching them, their hooks are invalid afterwards
+    **/
+    void reset(int64_t now) {
+        for (auto& x : this->slots) {
+            x = nullptr;
+        }
+        this->current = now;
+        this->count = 0;
+    }
+
+    /**
+    *  \brief Number of scheduled items
+    **/
+    size_t size() const {
+        return this->count;
+    }
+};
+
+#endif // __TIMING_WHEEL_HPP__
@@ -0,0 +1,130 @@
+#include <database/DBCache.hpp>
+
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+#include "TestUtils.hpp"
+
+/**
+*   Throughput of the worker cache under concurrent reads and writes
+*
+*   usage: DBCacheBench [keys = 100000] [maxThreads = 8] [opsPerThread = 500000]
+*
+*   Every thread does 90% get / 10% set on random keys of a warm cache, for 1, 2, 4, ... maxThreads threads.
+*   Compared with the cache before it was sharded: one shared_mutex over an unordered_map of the values.
+*   The sharded cache runs without a budget and with one that holds every key (the segments are kept in order then).
+**/
+
+/**
+*  \brief The single lock cache as it was before the shards
+**/
+class SharedMapCache {
+private:
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, std::pair<std::string, int>> entries;
+
+public:
+    std::optional<std::pair<std::string, int>> get(const std::string& key) {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        auto it = this->entries.find(key);
+        if (it == this->entries.end()) return std::nullopt;
+        return it->second;
+    }
+
+    void set(const std::string& key, const std::string& value, int ttl) {
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        this->entries[key] = std::pair<std::string, int>(value, ttl);
+    }
+};
+
+static std::string keyOf(size_t i) {
+    return "Player:" + std::to_string(i);
+}
+
+template<typename C>
+static void runLoad(const std::string& what, C& cache, size_t keyCount, size_t threads, size_t ops) {
+    std::vector<std::thread> workers;
+    std::atomic<size_t> hits = 0;
+    const std::string value(200, 'y');
+
+    auto start = test::clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&cache, &hits, &value, keyCount, ops, t]() {
+            std::mt19937 rng(static_cast<unsigned int>(t));
+            std::uniform_int_distribution<size_t> keyDist(0, keyCount - 1);
+            size_t found = 0;
+            for (size_t i = 0; i < ops; ++i) {
+                std::string key = keyOf(keyDist(rng));
+                if (i % 10 == 0) {
+                    cache.set(key, value, -1);
+                }
+                else if (cache.get(key)) {
+                    ++found;
+                }
+            }
+            hits += found;
+        });
+    }
+    for (auto& x : workers) {
+        x.join();
+    }
+    long long ms = std::max<long long>(test::millisSince(start), 1);
+
+    size_t total = threads * ops;
+    std::cout << what << ", " << threads << " thread(s): " << total * 1000 / ms << " ops/s" << std::endl;
+    // every key exists, all reads hit
+    CHECK(hits == threads * (ops - (ops + 9) / 10));
+}
+
+/**
+*  \brief DBCache::get takes the size limit of the result
+**/
+struct ShardedCache {
+    DBCache& cache;
+
+    std::optional<std::pair<std::string, int>> get(const std::string& key) {
+        return this->cache.get(key, SIZE_MAX);
+    }
+
+    void set(const std::string& key, const std::string& value, int ttl) {
+        this->cache.set(key, value, ttl);
+    }
+};
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    size_t keyCount = static_cast<size_t>(test::arg(argc, argv, 1, 100000));
+    size_t maxThreads = static_cast<size_t>(test::arg(argc, argv, 2, 8));
+    size_t ops = static_cast<size_t>(test::arg(argc, argv, 3, 500000));
+
+    // as DBManager sizes it for maxThreads executor threads, the budget of the sample config
+    DBCache unbounded(0, (maxThreads + 1) * 2);
+    DBCache bounded(256 * 1024 * 1024, (maxThreads + 1) * 2);
+    SharedMapCache before;
+    for (auto cache : { &unbounded, &bounded }) {
+        std::vector<DBKeyEntry> loaded;
+        loaded.reserve(keyCount);
+        for (size_t i = 0; i < keyCount; ++i) {
+            loaded.emplace_back(keyOf(i), std::pair<std::string, int>(std::string(200, 'x'), -1));
+        }
+        cache->beginWarmup();
+        CHECK(cache->loadWarmup(std::move(loaded)));
+        cache->finishWarmup(true);
+        CHECK(cache->size() == keyCount);
+    }
+    for (size_t i = 0; i < keyCount; ++i) {
+        before.set(keyOf(i), std::string(200, 'x'), -1);
+    }
+
+    ShardedCache sharded{ unbounded };
+    ShardedCache budgeted{ bounded };
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        runLoad("shared_mutex + unordered_map", before, keyCount, threads, ops);
+        runLoad("sharded DBCache", sharded, keyCount, threads, ops);
+        runLoad("sharded DBCache, 256 MB budget", budgeted, keyCount, threads, ops);
+    }
+
+    return test::result();
+}
@@ -0,0 +1,139 @@
+#include <epochserver/Dispatch.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+/**
+*   Resolving the callExtension function names
+*
+*   usage: DispatchBench [rounds = 200000]
+*
+*   Every name and code of dispatch::entries is resolved rounds times, by the strcmp / strncmp cascade
+*   of callExtensionEntrypoint before the perfect hash and by dispatch::lookup. Timed once over all of them
+*   and once over the names alone (the cascade answers the 2 char codes by their length).
+*   Every name the cascade knows has to resolve to the same code.
+**/
+
+/**
+*  \brief The former cascade of callExtensionEntrypoint with the by-name dbEntrypoint / beEntrypoint overloads
+*
+*  \return numeric code, nullptr if the function is unknown
+**/
+static const char* baselineLookup(const char* function) {
+    size_t fncLen = strlen(function);
+
+    if (fncLen == 2) {
+        return function;
+    }
+    else if (!strncmp(function, "db", 2)) {
+        function += 2;
+        if (!strcmp(function, "Get")) return "11";
+        if (!strcmp(function, "Exists")) return "16";
+        if (!strcmp(function, "Set")) return "13";
+        if (!strcmp(function, "SetEx")) return "14";
+        if (!strcmp(function, "Expire")) return "17";
+        if (!strcmp(function, "Del")) return "18";
+        if (!strcmp(function, "Query")) return "15";
+        if (!strcmp(function, "GetTtl")) return "12";
+        if (!strcmp(function, "GetRange")) return "19";
+        if (!strcmp(function, "Ping")) return "10";
+        return nullptr;
+    }
+    else if (!strncmp(function, "be", 2)) {
+        if (!strcmp(function, "beBroadcastMessage")) return "20";
+        if (!strcmp(function, "beKick")) return "21";
+        if (!strcmp(function, "beBan")) return "22";
+        if (!strcmp(function, "beShutdown")) return "25";
+        if (!strcmp(function, "beLock")) return "23";
+        if (!strcmp(function, "beUnlock")) return "24";
+        return nullptr;
+    }
+    else if (!strcmp(function, "playerCheck")) {
+        return "30";
+    }
+    else if (!strcmp(function, "log")) {
+        return "91";
+    }
+    else if (!strcmp(function, "getCurrentTime")) {
+        return "00";
+    }
+    else if (!strcmp(function, "getRandomString")) {
+        return "01";
+    }
+    else if (!strcmp(function, "getStringMd5")) {
+        return "02";
+    }
+    else if (!strcmp(function, "version")) {
+        return "90";
+    }
+    return nullptr;
+}
+
+static void report(const std::string& what, size_t ops, long long us) {
+    us = std::max<long long>(us, 1);
+    std::cout << what << ": " << ops << " lookups in " << us / 1000 << "ms (" << us * 1000.0 / ops << "ns per lookup)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    size_t rounds = static_cast<size_t>(test::arg(argc, argv, 1, 200000));
+
+    // the names are copied, Arma hands over a fresh string per call
+    std::vector<std::string> names;
+    for (auto& entry : dispatch::entries) {
+        names.emplace_back(entry.name);
+    }
+
+    size_t compared = 0;
+    for (auto& entry : dispatch::entries) {
+        std::string name(entry.name);
+        const char* baseline = baselineLookup(name.c_str());
+        if (!baseline) continue;
+
+        const char* code = dispatch::lookup(name);
+        CHECK(code && !strcmp(code, baseline));
+        if (code && strcmp(code, baseline)) {
+            std::cout << name << ": cascade " << baseline << ", lookup " << code << std::endl;
+        }
+        ++compared;
+    }
+    CHECK(!dispatch::lookup("unknown") && !baselineLookup("unknown"));
+    std::cout << compared << " of " << names.size() << " names are known to the cascade and resolve to the same code" << std::endl;
+
+    // summed up, so the lookups are not optimized away
+    size_t sum = 0;
+    auto run = [&sum, rounds](const std::string& what, const std::vector<std::string>& list) {
+        auto start = test::clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto& name : list) {
+                const char* code = baselineLookup(name.c_str());
+                sum += code ? static_cast<size_t>(code[1]) : 0;
+            }
+        }
+        report("strcmp cascade, " + what, rounds * list.size(), test::microsSince(start));
+
+        start = test::clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto& name : list) {
+                const char* code = dispatch::lookup(name);
+                sum += code ? static_cast<size_t>(code[1]) : 0;
+            }
+        }
+        report("perfect hash, " + what, rounds * list.size(), test::microsSince(start));
+    };
+
+    // the cascade answers the numeric codes by their length, the names walk the compares
+    std::vector<std::string> longNames;
+    for (auto& name : names) {
+        if (name.size() != 2) longNames.push_back(name);
+    }
+    run("names and codes", names);
+    run("names only", longNames);
+
+    CHECK(sum > 0);
+    return test::result();
+}
@@ -0,0 +1,84 @@
+#include <threading/Executor.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "TestUtils.hpp"
+
+/**
+*   Read latency of an executor under a write-heavy load
+*
+*   usage: ExecutorBench [rounds = 50] [threads = 4] [writeMicros = 2000]
+*
+*   Each round queues a burst of writes (each blocks its thread for writeMicros, like a db round trip)
+*   that keeps the threads busy for 80% of the round, and issues a read every millisecond meanwhile.
+*   The reads are issued once with HIGH priority (lanes) and once with the priority of the writes (a single FIFO),
+*   p50 / p99 / max of their queue-to-done latency are printed for both.
+**/
+
+struct Run {
+    std::vector<long long> reads;
+    long long ms;
+};
+
+static Run runLoad(size_t rounds, size_t threads, long long writeMicros, Executor::Priority readPriority) {
+    const auto roundTime = std::chrono::milliseconds(50);
+    const size_t burst = static_cast<size_t>(threads * roundTime.count() * 1000 * 8 / 10 / writeMicros);
+
+    Run run;
+    auto latencies = std::make_shared<std::vector<long long>>();
+    auto latencyMutex = std::make_shared<std::mutex>();
+    auto start = test::clock::now();
+    {
+        Executor executor("bench", threads, 0);
+
+        for (size_t round = 0; round < rounds; ++round) {
+            for (size_t i = 0; i < burst; ++i) {
+                executor.fireAndForget([writeMicros]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(writeMicros));
+                }, Executor::Priority::NORMAL);
+            }
+
+            auto roundEnd = test::clock::now() + roundTime;
+            while (test::clock::now() < roundEnd) {
+                auto issued = test::clock::now();
+                executor.fireAndForget([issued, latencies, latencyMutex]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    long long micros = test::microsSince(issued);
+                    std::lock_guard<std::mutex> lock(*latencyMutex);
+                    latencies->push_back(micros);
+                }, readPriority);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        // the destructor works off the rest
+    }
+    run.ms = test::millisSince(start);
+    run.reads = std::move(*latencies);
+    return run;
+}
+
+static void report(const std::string& what, Run& run) {
+    long long p50 = test::percentile(run.reads, 50);
+    long long p99 = test::percentile(run.reads, 99);
+    long long max = run.reads.empty() ? 0 : run.reads.back();
+    std::cout << what << ": " << run.reads.size() << " reads in " << run.ms << "ms, latency p50 " << p50 / 1000.0
+        << "ms, p99 " << p99 / 1000.0 << "ms, max " << max / 1000.0 << "ms" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    size_t rounds = static_cast<size_t>(test::arg(argc, argv, 1, 50));
+    size_t threads = static_cast<size_t>(test::arg(argc, argv, 2, 4));
+    long long writeMicros = test::arg(argc, argv, 3, 2000);
+
+    auto fifo = runLoad(rounds, threads, writeMicros, Executor::Priority::NORMAL);
+    report("single FIFO", fifo);
+
+    auto lanes = runLoad(rounds, threads, writeMicros, Executor::Priority::HIGH);
+    report("priority lanes", lanes);
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <database/DBManager.hpp>
+
+#include <cstdio>
+
+#include "TestUtils.hpp"
+
+/**
+*   Order of the calls on one key
+*
+*   usage: KeyOrderTest [redisIp] [redisPort = 6379] [redisPassword = ""]
+*
+*   Interleaves set, get, setEx, getWithTtl, del and exists on one key without waiting for the results,
+*   every read has to see the last write issued before it.
+*   Runs against SQLite with more executor threads than connections (reads must not hold the connection the write needs),
+*   and against redis with async calls if a server is given.
+**/
+
+static const std::string key = "Order:1";
+
+static void interleave(DBManager& manager, const std::string& worker, size_t rounds) {
+    struct Read {
+        std::shared_future<DBReturn> result;
+        std::string expected;
+        bool withTtl;
+    };
+    std::vector<Read> reads;
+    std::vector<std::shared_future<DBReturn>> writes;
+    std::vector<std::shared_future<DBReturn>> absent;
+
+    auto start = test::clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        std::string value = "v" + std::to_string(i);
+
+        writes.push_back(manager.set<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key), std::string(value)));
+        reads.push_back({ manager.get<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key)), value, false });
+
+        writes.push_back(manager.setEx<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key), 600, value + "x"));
+        reads.push_back({ manager.getWithTtl<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key)), value + "x", true });
+
+        writes.push_back(manager.del<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key)));
+        reads.push_back({ manager.get<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key)), "", false });
+        absent.push_back(manager.exists<DBExecutionType::ASYNC_FUTURE>(worker, std::string(key)));
+    }
+
+    for (auto& x : writes) {
+        CHECK(std::get<bool>(x.get()));
+    }
+    size_t stale = 0;
+    for (auto& x : absent) {
+        if (std::get<bool>(x.get())) ++stale;
+    }
+    for (auto& x : reads) {
+        DBReturn result = x.result.get();
+        std::string value = x.withTtl ? std::get<std::pair<std::string, int>>(result).first : std::get<std::string>(result);
+        if (value != x.expected) ++stale;
+    }
+    CHECK(stale == 0);
+    std::cout << worker << ": " << rounds << " rounds in " << test::millisSince(start) << "ms, " << stale << " stale reads" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    std::remove("order_test.db3");
+
+    std::string config = "{\"sqlite\":{\"type\":\"sqlite\",\"database\":\"order_test\",\"disableCache\":true,"
+        "\"executor\":{\"threads\":4},\"pool\":{\"max\":1,\"checkoutTimeoutMs\":2000}}";
+    if (argc > 1) {
+        std::string port = argc > 2 ? argv[2] : "6379";
+        std::string password = argc > 3 ? argv[3] : "";
+        config += ",\"redis\":{\"type\":\"redis\",\"ip\":\"" + std::string(argv[1]) + "\",\"port\":" + port +
+            ",\"password\":\"" + password + "\",\"database\":\"0\",\"async\":true,\"disableCache\":true}";
+    }
+    config += "}";
+
+    rapidjson::Document doc;
+    doc.Parse(config.c_str());
+    {
+        DBManager manager(doc);
+        interleave(manager, "sqlite", 200);
+        if (argc > 1) {
+            interleave(manager, "redis", 2000);
+        }
+    }
+
+    std::remove("order_test.db3");
+    return test::result();
+}
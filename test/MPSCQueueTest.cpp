@@ -0,0 +1,94 @@
+#include <threading/MPSCQueue.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "TestUtils.hpp"
+
+/**
+*   Stress test of the callback result queue
+*
+*   usage: MPSCQueueTest [producers = 16] [itemsPerProducer = 20000]
+*
+*   Many producer threads (the db workers) push at once while one consumer (the game thread polling "90") drains the queue.
+*   Every item has to arrive exactly once and in the order of its producer, p50 / p99 of the push-to-pop latency are printed.
+**/
+
+struct Item {
+    size_t producer = 0;
+    size_t seq = 0;
+    test::clock::time_point pushed;
+};
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    size_t producers = static_cast<size_t>(test::arg(argc, argv, 1, 16));
+    size_t items = static_cast<size_t>(test::arg(argc, argv, 2, 20000));
+
+    MPSCQueue<Item> queue;
+    std::atomic<size_t> started = 0;
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p < producers; ++p) {
+        workers.emplace_back([&queue, &started, producers, items, p]() {
+            // push together, not one producer after the other
+            ++started;
+            while (started < producers) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < items; ++i) {
+                queue.push(Item{ p, i, test::clock::now() });
+            }
+        });
+    }
+
+    std::vector<size_t> nextSeq(producers, 0);
+    std::vector<long long> latencies;
+    latencies.reserve(producers * items);
+    size_t outOfOrder = 0;
+
+    auto start = test::clock::now();
+    Item item;
+    while (latencies.size() < producers * items) {
+        if (!queue.pop(item)) {
+            // give up instead of spinning forever if items got lost
+            if (test::millisSince(start) > 60000) break;
+            std::this_thread::yield();
+            continue;
+        }
+        latencies.push_back(test::microsSince(item.pushed));
+        if (item.producer >= producers || item.seq != nextSeq[item.producer]) {
+            ++outOfOrder;
+            continue;
+        }
+        ++nextSeq[item.producer];
+    }
+    long long ms = test::millisSince(start);
+    for (auto& x : workers) {
+        x.join();
+    }
+
+    CHECK(latencies.size() == producers * items);
+    CHECK(outOfOrder == 0);
+    for (size_t p = 0; p < producers; ++p) {
+        CHECK(nextSeq[p] == items);
+    }
+    CHECK(queue.empty());
+    CHECK(!queue.pop(item));
+
+    long long p50 = test::percentile(latencies, 50);
+    long long p99 = test::percentile(latencies, 99);
+    std::cout << producers << " producers, " << latencies.size() << " items in " << ms << "ms, delivery latency p50 "
+        << p50 << "us, p99 " << p99 << "us" << std::endl;
+
+    // elements left behind are freed with the queue
+    {
+        MPSCQueue<std::string> rest;
+        rest.push("a");
+        rest.push("b");
+        std::string first;
+        CHECK(rest.pop(first) && first == "a");
+    }
+
+    return test::result();
+}
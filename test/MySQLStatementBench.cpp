@@ -0,0 +1,117 @@
+#include <database/MySQLConnector.hpp>
+
+#include <mariadb++/connection.hpp>
+
+#include <functional>
+
+#include "TestUtils.hpp"
+
+/**
+*   Prepared statement cache of the MySQL connector against a local MariaDB
+*
+*   usage: MySQLStatementBench [ip = 127.0.0.1] [port = 3306] [user = root] [password = ""] [database = epoch_bench] [ops = 20000]
+*
+*   Without the cache: every call prepares its statement text on the connection, as the connector did before.
+*   With the cache: the calls of MySQLConnector, which prepare each statement once per connection.
+*   Both run GET, GET with TTL and SETEX on the same keys of the connector's table.
+**/
+
+static const size_t keyCount = 1000;
+static const std::string table = "`KeyValueTable`";
+static const std::string alive = " AND (`ttl` IS NULL OR `ttl` > CURRENT_TIMESTAMP())";
+static const std::string remaining = "UNIX_TIMESTAMP(`ttl`) - UNIX_TIMESTAMP(CURRENT_TIMESTAMP())";
+
+static std::string keyOf(size_t i) {
+    return "Bench:" + std::to_string(i);
+}
+
+static void report(const std::string& what, size_t ops, long long ms) {
+    ms = std::max<long long>(ms, 1);
+    std::cout << what << ": " << ops << " calls in " << ms << "ms (" << ops * 1000 / ms << " calls/s, "
+        << ms * 1000.0 / ops << "us per call)" << std::endl;
+}
+
+/**
+*  \brief Prepares text and runs it with the key (and ttl + value), like the connector before the cache
+**/
+static bool runUncached(mariadb::connection_ref& con, const std::string& text, const std::string& key, bool write) {
+    auto statement = con->create_statement(text);
+    if (!statement || statement->error_no() != 0) return false;
+
+    if (write) {
+        statement->set_string(0, key);
+        statement->set_string(1, std::string(200, 'y'));
+        statement->set_signed32(2, 3600);
+        statement->execute();
+        return statement->error_no() == 0;
+    }
+
+    statement->set_string(0, key);
+    auto res = statement->query();
+    return res && res->error_no() == 0 && res->next();
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    DBConfig config;
+    config.connectionName = "bench";
+    config.dbType = DBType::MY_SQL;
+    config.ip = argc > 1 ? argv[1] : "127.0.0.1";
+    config.port = static_cast<int>(test::arg(argc, argv, 2, 3306));
+    config.user = argc > 3 ? argv[3] : "root";
+    config.password = argc > 4 ? argv[4] : "";
+    config.dbname = argc > 5 ? argv[5] : "epoch_bench";
+    size_t ops = static_cast<size_t>(test::arg(argc, argv, 6, 20000));
+
+    // creates the schema and the table
+    MySQLConnector connector(config);
+    for (size_t i = 0; i < keyCount; ++i) {
+        CHECK(connector.setEx(keyOf(i), 3600, std::string(200, 'x')));
+    }
+
+    auto con = mariadb::connection::create(mariadb::account::create(config.ip, config.user, config.password, "", config.port));
+    if (!CHECK(con->connect() && con->set_schema(config.dbname))) {
+        return test::result();
+    }
+
+    // the texts of the connector's GET, GET_WITH_TTL and SET_EX statements
+    const std::string getText = "SELECT `value` FROM " + table + " WHERE `key`=?" + alive;
+    const std::string getWithTtlText = "SELECT `value`, " + remaining + " FROM " + table + " WHERE `key`=?" + alive;
+    const std::string setExText = "INSERT INTO " + table + " (`key`,`value`,`ttl`) VALUES (?,?,DATE_ADD(NOW(),INTERVAL ? SECOND))"
+        " ON DUPLICATE KEY UPDATE value = VALUES(value), ttl = VALUES(ttl)";
+
+    struct Call {
+        std::string what;
+        std::string text;
+        bool write;
+        std::function<bool(const std::string&)> cached;
+    };
+    std::vector<Call> calls = {
+        { "GET", getText, false, [&connector](const std::string& key) { return !connector.get(key).empty(); } },
+        { "GET with TTL", getWithTtlText, false, [&connector](const std::string& key) { return !connector.getWithTtl(key).first.empty(); } },
+        { "SETEX", setExText, true, [&connector](const std::string& key) { return connector.setEx(key, 3600, std::string(200, 'y')); } }
+    };
+    for (auto& call : calls) {
+        size_t ok = 0;
+        auto start = test::clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            if (runUncached(con, call.text, keyOf(i % keyCount), call.write)) ++ok;
+        }
+        report(call.what + ", prepared per call", ops, test::millisSince(start));
+        CHECK(ok == ops);
+
+        ok = 0;
+        start = test::clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            if (call.cached(keyOf(i % keyCount))) ++ok;
+        }
+        report(call.what + ", statement cache", ops, test::millisSince(start));
+        CHECK(ok == ops);
+    }
+
+    for (size_t i = 0; i < keyCount; ++i) {
+        connector.del(keyOf(i));
+    }
+    return test::result();
+}
@@ -0,0 +1,145 @@
+#include <database/RedisConnector.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+
+#include "TestUtils.hpp"
+
+/**
+*   Round trips of the redis connector against a local redis-server
+*
+*   usage: RedisPipelineBench [ip = 127.0.0.1] [port = 6379] [password = ""] [threads = 8] [opsPerThread = 10000]
+*
+*   getWithTtl of one caller: GET and TTL one after the other (the former two round trips) against one pipelined GET+TTL.
+*   getWithTtl of concurrent callers: one connector per thread (the pool without pipelining)
+*   against one shared pipelined connector, and against the async calls on that connector.
+**/
+
+static const size_t keyCount = 1000;
+
+static std::string keyOf(size_t i) {
+    return "Bench:" + std::to_string(i);
+}
+
+static void report(const std::string& what, size_t ops, long long ms) {
+    ms = std::max<long long>(ms, 1);
+    std::cout << what << ": " << ops << " ops in " << ms << "ms (" << ops * 1000 / ms << " ops/s, "
+        << ms * 1000.0 / ops << "us per op)" << std::endl;
+}
+
+/**
+*  \brief Every thread calls getWithTtl on its connector ops times, returns the ms taken
+**/
+static long long runThreads(std::vector<RedisConnector*> connectors, size_t ops) {
+    std::vector<std::thread> workers;
+    std::atomic<size_t> found = 0;
+
+    auto start = test::clock::now();
+    for (size_t t = 0; t < connectors.size(); ++t) {
+        workers.emplace_back([connector = connectors[t], &found, ops, t]() {
+            size_t hits = 0;
+            for (size_t i = 0; i < ops; ++i) {
+                if (!connector->getWithTtl(keyOf((t + i) % keyCount)).first.empty()) {
+                    ++hits;
+                }
+            }
+            found += hits;
+        });
+    }
+    for (auto& x : workers) {
+        x.join();
+    }
+    long long ms = test::millisSince(start);
+
+    CHECK(found == connectors.size() * ops);
+    return ms;
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    DBConfig config;
+    config.connectionName = "bench";
+    config.dbType = DBType::REDIS;
+    config.ip = argc > 1 ? argv[1] : "127.0.0.1";
+    config.port = static_cast<int>(test::arg(argc, argv, 2, 6379));
+    config.password = argc > 3 ? argv[3] : "";
+    size_t threads = static_cast<size_t>(test::arg(argc, argv, 4, 8));
+    size_t ops = static_cast<size_t>(test::arg(argc, argv, 5, 10000));
+
+    DBConfig pipelinedConfig = config;
+    pipelinedConfig.redisPipeline = true;
+
+    std::vector<std::unique_ptr<RedisConnector>> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.push_back(std::make_unique<RedisConnector>(config));
+    }
+    RedisConnector shared(pipelinedConfig);
+
+    for (size_t i = 0; i < keyCount; ++i) {
+        CHECK(pool.front()->setEx(keyOf(i), 3600, std::string(200, 'x')));
+    }
+
+    // one caller
+    {
+        auto& connector = *pool.front();
+        auto start = test::clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            std::string key = keyOf(i % keyCount);
+            CHECK(!connector.get(key).empty());
+            connector.ttl(key);
+        }
+        report("GET, then TTL", ops, test::millisSince(start));
+
+        start = test::clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            CHECK(!connector.getWithTtl(keyOf(i % keyCount)).first.empty());
+        }
+        report("GET+TTL in one round trip", ops, test::millisSince(start));
+    }
+
+    // concurrent callers
+    {
+        std::vector<RedisConnector*> own;
+        for (auto& connector : pool) {
+            own.push_back(connector.get());
+        }
+        report(std::to_string(threads) + " threads, one connector each", threads * ops, runThreads(own, ops));
+
+        std::vector<RedisConnector*> one(threads, &shared);
+        report(std::to_string(threads) + " threads, one pipelined connector", threads * ops, runThreads(one, ops));
+    }
+
+    // async calls, no thread waits for the replies
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t completed = 0;
+        size_t hits = 0;
+
+        auto start = test::clock::now();
+        for (size_t i = 0; i < threads * ops; ++i) {
+            shared.getWithTtlAsync(keyOf(i % keyCount), [&](std::pair<std::string, int>&& result, bool failed) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failed && !result.first.empty()) {
+                    ++hits;
+                }
+                ++completed;
+                done.notify_one();
+            });
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&]() { return completed == threads * ops; });
+        }
+        report("async GET+TTL, one pipelined connector", threads * ops, test::millisSince(start));
+        CHECK(hits == threads * ops);
+    }
+
+    for (size_t i = 0; i < keyCount; ++i) {
+        pool.front()->del(keyOf(i));
+    }
+    return test::result();
+}
@@ -0,0 +1,136 @@
+#include <database/DBManager.hpp>
+#include <database/SQLiteConnector.hpp>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "TestUtils.hpp"
+
+/**
+*   Write-through of the worker cache against a SQLite database
+*
+*   Every write goes through DBManager, afterwards the cached state of the key has to match the database:
+*   a hit has the value and ttl of the database, a known absent key does not exist there.
+*   Writes that fail in the database must not leave their value in the cache.
+**/
+
+static const std::string dbName = "cache_test";
+static const std::string worker = "test";
+
+/**
+*  \brief Checks the cache against the database, hit: whether the key has to be cached (or known absent)
+**/
+static void checkKey(DBManager& manager, SQLiteConnector& db, const std::string& key, bool hit) {
+    auto stored = db.getWithTtl(key);
+    auto cached = manager.getCached(worker, key, SIZE_MAX);
+
+    if (stored.first.empty()) {
+        CHECK(!cached);
+        if (hit) {
+            CHECK(manager.isKnownAbsent(worker, key));
+        }
+        return;
+    }
+
+    CHECK(!manager.isKnownAbsent(worker, key));
+    if (!CHECK(cached || !hit) || !cached) return;
+
+    CHECK(cached->first == stored.first);
+    if (stored.second < 0) {
+        CHECK(cached->second == -1);
+    }
+    else {
+        CHECK(std::abs(cached->second - stored.second) <= 1);
+    }
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    std::remove((dbName + ".db3").c_str());
+
+    DBConfig config;
+    config.connectionName = worker;
+    config.dbType = DBType::SQLITE;
+    config.dbname = dbName;
+    SQLiteConnector db(config);
+
+    CHECK(db.set("Loaded:1", "before"));
+    CHECK(db.setEx("Loaded:2", 600, "expiring"));
+
+    rapidjson::Document doc;
+    doc.Parse(("{\"" + worker + "\":{\"type\":\"sqlite\",\"database\":\"" + dbName + "\"}}").c_str());
+    DBManager manager(doc);
+
+    while (manager.getCacheStatus().front().state == DBCache::State::WARMING) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(manager.getCacheStatus().front().state == DBCache::State::WARM);
+    checkKey(manager, db, "Loaded:1", true);
+    checkKey(manager, db, "Loaded:2", true);
+
+    // write-through of every write
+    CHECK(std::get<bool>(manager.set<DBExecutionType::SYNC>(worker, "Key:1", "a")));
+    checkKey(manager, db, "Key:1", true);
+
+    CHECK(std::get<bool>(manager.setEx<DBExecutionType::SYNC>(worker, "Key:1", 300, "b")));
+    checkKey(manager, db, "Key:1", true);
+
+    // a set without ttl makes the key persistent again
+    CHECK(std::get<bool>(manager.set<DBExecutionType::SYNC>(worker, "Key:1", "c")));
+    checkKey(manager, db, "Key:1", true);
+
+    CHECK(std::get<bool>(manager.expire<DBExecutionType::SYNC>(worker, "Key:1", 120)));
+    checkKey(manager, db, "Key:1", true);
+
+    CHECK(std::get<bool>(manager.del<DBExecutionType::SYNC>(worker, "Key:1")));
+    checkKey(manager, db, "Key:1", true);
+
+    CHECK(std::get<bool>(manager.setMany<DBExecutionType::SYNC>(worker, { { "Key:2", "d" }, { "Key:3", "e" } })));
+    checkKey(manager, db, "Key:2", true);
+    checkKey(manager, db, "Key:3", true);
+
+    CHECK(std::get<bool>(manager.setExMany<DBExecutionType::SYNC>(worker, {
+        { "Key:2", { "f", 60 } },
+        { "Key:3", { "g", -1 } }
+    })));
+    checkKey(manager, db, "Key:2", true);
+    checkKey(manager, db, "Key:3", true);
+
+    // the async path ends in the same state
+    CHECK(std::get<bool>(manager.setEx<DBExecutionType::ASYNC_FUTURE>(worker, "Key:4", 90, "h").get()));
+    checkKey(manager, db, "Key:4", true);
+    CHECK(std::get<bool>(manager.del<DBExecutionType::ASYNC_FUTURE>(worker, "Key:4").get()));
+    checkKey(manager, db, "Key:4", true);
+
+    // writes the database rejects (table renamed away) are not kept in the cache
+    {
+        SQLite::Database raw(dbName + ".db3", SQLite::OPEN_READWRITE);
+        raw.exec("ALTER TABLE KeyValueTable RENAME TO KeyValueTableOff");
+
+        CHECK(!std::get<bool>(manager.set<DBExecutionType::SYNC>(worker, "Key:2", "lost")));
+        CHECK(!std::get<bool>(manager.setEx<DBExecutionType::ASYNC_FUTURE>(worker, "Key:5", 60, "lost").get()));
+        CHECK(!std::get<bool>(manager.del<DBExecutionType::SYNC>(worker, "Key:3")));
+        CHECK(!std::get<bool>(manager.setMany<DBExecutionType::SYNC>(worker, { { "Key:6", "lost" } })));
+
+        CHECK(!manager.getCached(worker, "Key:2", SIZE_MAX));
+        CHECK(!manager.getCached(worker, "Key:5", SIZE_MAX));
+        CHECK(!manager.getCached(worker, "Key:6", SIZE_MAX));
+        CHECK(!manager.isKnownAbsent(worker, "Key:3"));
+
+        raw.exec("ALTER TABLE KeyValueTableOff RENAME TO KeyValueTable");
+    }
+    checkKey(manager, db, "Key:2", false);
+    checkKey(manager, db, "Key:3", false);
+    checkKey(manager, db, "Key:5", false);
+    checkKey(manager, db, "Key:6", false);
+
+    // invalidated keys are never answered as absent, the read goes to the database
+    CHECK(std::get<std::string>(manager.get<DBExecutionType::SYNC>(worker, "Key:2")) == "f");
+    CHECK(!manager.isKnownAbsent(worker, "Key:6"));
+
+    return test::result();
+}
@@ -0,0 +1,11 @@
+#include <main.hpp>
+
+/**
+*   Globals of main.cpp for the test programs, the tests set up what they use
+**/
+
+std::unique_ptr<ThreadPool> threadpool;
+
+namespace logging {
+    std::shared_ptr<spdlog::logger> logfile;
+}
@@ -0,0 +1,7 @@
+#include <epochserver/epochserver.hpp>
+
+/**
+*   Server instance of main.cpp for the test programs that link the whole core, stays empty
+**/
+
+std::unique_ptr<EpochServer> server;
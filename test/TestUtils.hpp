@@ -0,0 +1,83 @@
+#pragma once
+
+#ifndef __EPOCH_TEST_UTILS_HPP__
+#define __EPOCH_TEST_UTILS_HPP__
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <main.hpp>
+#include <spdlog/sinks/stdout_sinks.h>
+
+/**
+*   Helpers of the core tests and benchmarks
+*
+*   Tests count failed CHECKs and return result() from main, benchmarks print their numbers.
+**/
+namespace test {
+
+    inline int failures = 0;
+
+    inline bool check(bool ok, const char* what, const char* file, int line) {
+        if (!ok) {
+            ++failures;
+            std::cout << file << ":" << line << ": CHECK failed: " << what << std::endl;
+        }
+        return ok;
+    }
+
+#define CHECK(x) test::check((x), #x, __FILE__, __LINE__)
+
+    /**
+    *  \brief Exit code of a test, prints the summary
+    **/
+    inline int result() {
+        if (failures > 0) {
+            std::cout << failures << " checks failed" << std::endl;
+            return 1;
+        }
+        std::cout << "All checks passed" << std::endl;
+        return 0;
+    }
+
+    /**
+    *  \brief Logs of the core to stdout (warnings only, the log file is set up by the extension init)
+    **/
+    inline void initLogging() {
+        logging::logfile = spdlog::stdout_logger_mt("test");
+        logging::logfile->set_level(spdlog::level::warn);
+    }
+
+    typedef std::chrono::steady_clock clock;
+
+    inline long long microsSince(clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+    }
+
+    inline long long millisSince(clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    }
+
+    /**
+    *  \brief p-th percentile (0..100) of the samples, sorts them
+    **/
+    template<typename T>
+    T percentile(std::vector<T>& samples, double p) {
+        if (samples.empty()) return T();
+        std::sort(samples.begin(), samples.end());
+        size_t index = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    }
+
+    /**
+    *  \brief Numeric argument i of the command line or fallback
+    **/
+    inline long long arg(int argc, char** argv, int i, long long fallback) {
+        return argc > i ? std::stoll(argv[i]) : fallback;
+    }
+};
+
+#endif // __EPOCH_TEST_UTILS_HPP__
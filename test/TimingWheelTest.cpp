@@ -0,0 +1,78 @@
+#include <threading/TimingWheel.hpp>
+
+#include "TestUtils.hpp"
+
+/**
+*   Schedule, reschedule and cancel of the expiry wheel
+*
+*   Every item has to fire once, in the tick of its last deadline, cancelled items never.
+*   Rescheduling an item many times must not add it to the wheel again.
+**/
+
+struct Item {
+    size_t id = 0;
+    long long fired = -1;
+    TimingWheelHook<Item> hook;
+};
+
+struct HookOf {
+    TimingWheelHook<Item>& operator()(Item* item) const {
+        return item->hook;
+    }
+};
+
+int main() {
+    test::initLogging();
+
+    const int64_t start = 1000;
+    const int64_t far = start + 64LL * 64 * 64 * 64 * 3;
+    TimingWheel<Item, HookOf> wheel(start);
+
+    std::vector<Item> items(5000);
+    std::vector<int64_t> deadlines(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i].id = i;
+        deadlines[i] = start + 1 + static_cast<int64_t>(i * 7919 % 300000);
+        wheel.schedule(&items[i], deadlines[i]);
+    }
+
+    // a hot key rewritten with new deadlines stays one item
+    for (int64_t i = 0; i < 1000; ++i) {
+        wheel.schedule(&items[0], start + 50 + i % 10);
+    }
+    deadlines[0] = start + 50 + 999 % 10;
+    CHECK(wheel.size() == items.size());
+
+    wheel.cancel(&items[1]);
+    wheel.cancel(&items[1]);
+    CHECK(wheel.size() == items.size() - 1);
+
+    // beyond the range of the levels, parked and cascaded later
+    wheel.schedule(&items[2], far);
+    deadlines[2] = far;
+
+    int64_t now = start;
+    while (now < far + 64) {
+        now += now < start + 400000 ? 37 : 64 * 64 * 64;
+        wheel.advance(now, [now](Item* item) {
+            CHECK(item->hook.deadline == -1);
+            CHECK(item->fired == -1);
+            item->fired = now;
+        });
+    }
+    CHECK(wheel.size() == 0);
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (i == 1) {
+            CHECK(items[i].fired == -1);
+        }
+        else if (i == 2) {
+            CHECK(items[i].fired >= deadlines[i]);
+        }
+        else if (!CHECK(items[i].fired >= deadlines[i] && items[i].fired < deadlines[i] + 37)) {
+            std::cout << "item " << i << " due " << deadlines[i] << " fired " << items[i].fired << std::endl;
+        }
+    }
+
+    return test::result();
+}
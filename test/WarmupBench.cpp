@@ -0,0 +1,86 @@
+#include <database/DBManager.hpp>
+#include <database/SQLiteConnector.hpp>
+
+#include <cstdio>
+#include <thread>
+
+#include "TestUtils.hpp"
+
+/**
+*   Cache warm-up of a synthetic keyspace in a SQLite file
+*
+*   usage: WarmupBench [keys = 500000] [threads = 4]
+*
+*   Compares the old fill (keys + one getWithTtl per key) with the paged warm-up of DBManager
+*   on one executor thread and on several (pages are read by one thread and inserted by the others).
+**/
+
+static const std::string dbName = "warmup_bench";
+
+static void report(const std::string& what, long long ms, size_t keys) {
+    std::cout << what << ": " << keys << " keys in " << ms << "ms (" << (ms > 0 ? keys * 1000 / ms : keys) << " keys/s)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test::initLogging();
+
+    size_t keyCount = static_cast<size_t>(test::arg(argc, argv, 1, 500000));
+    size_t threads = static_cast<size_t>(test::arg(argc, argv, 2, 4));
+
+    std::remove((dbName + ".db3").c_str());
+
+    DBConfig config;
+    config.connectionName = "bench";
+    config.dbType = DBType::SQLITE;
+    config.dbname = dbName;
+
+    {
+        SQLiteConnector connector(config);
+
+        // player blobs of a few hundred bytes, every tenth key expires
+        auto start = test::clock::now();
+        std::vector<DBKeyEntry> chunk;
+        for (size_t i = 0; i < keyCount; ++i) {
+            chunk.emplace_back("Player:" + std::to_string(i), std::pair<std::string, int>(std::string(200 + i % 300, 'x'), i % 10 == 0 ? 3600 : -1));
+            if (chunk.size() == 10000 || i + 1 == keyCount) {
+                CHECK(connector.setExMany(chunk));
+                chunk.clear();
+            }
+        }
+        report("fill", test::millisSince(start), keyCount);
+
+        // before: one query for the keys, then one per key
+        start = test::clock::now();
+        DBCache cache;
+        cache.beginWarmup();
+        std::vector<DBKeyEntry> loaded;
+        for (auto& key : connector.keys("")) {
+            auto entry = connector.getWithTtl(key);
+            loaded.emplace_back(std::move(key), std::move(entry));
+        }
+        cache.finishWarmup(cache.loadWarmup(std::move(loaded)));
+        report("keys + getWithTtl", test::millisSince(start), cache.size());
+        CHECK(cache.size() == keyCount);
+    }
+
+    for (size_t executorThreads : { static_cast<size_t>(1), threads }) {
+        rapidjson::Document doc;
+        doc.Parse(("{\"bench\":{\"type\":\"sqlite\",\"database\":\"" + dbName + "\",\"executor\":{\"threads\":" + std::to_string(executorThreads) + "}}}").c_str());
+
+        auto start = test::clock::now();
+        DBManager manager(doc);
+
+        DBManager::CacheStatus status;
+        do {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            status = manager.getCacheStatus().front();
+        } while (status.state == DBCache::State::WARMING);
+
+        report("paged warm-up, " + std::to_string(executorThreads) + " thread(s)", test::millisSince(start), status.keys);
+        CHECK(status.state == DBCache::State::WARM);
+        CHECK(status.keys == keyCount);
+    }
+
+    std::remove((dbName + ".db3").c_str());
+    return test::result();
+}